@@ -0,0 +1,233 @@
+#include "Bitboard.hpp"
+#include "utils/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// the largest sum is 2 * 8 + 16 = 32 for the weighted neighborhood
+const uint32_t maxCounterBits = 6;
+
+uint64_t popCount(uint64_t word)
+{
+  uint64_t count = 0;
+  while (word)
+  {
+    word &= word - 1;
+    count++;
+  }
+  return count;
+}
+} // namespace
+
+Bitboard::Bitboard(uint64_t width, uint64_t height)
+  : m_width(width),
+    m_height(height),
+    m_wordsPerRow((width + 63) / 64),
+    m_lastWordMask(width % 64 ? (1ull << (width % 64)) - 1 : ~0ull),
+    m_cells(m_wordsPerRow * height, 0),
+    m_next(m_wordsPerRow * height, 0),
+    m_extended((m_wordsPerRow + 2) * (height + 1), 0)
+{
+}
+
+void Bitboard::load(Grid& grid)
+{
+  const uint8_t* data = grid.getData();
+  std::fill(m_cells.begin(), m_cells.end(), 0);
+  for (uint64_t row = 0; row < m_height; row++)
+  {
+    for (uint64_t col = 0; col < m_width; col++)
+    {
+      if (data[(row * m_width + col) * 4 + 3] != 0)
+        m_cells[row * m_wordsPerRow + col / 64] |= 1ull << (col % 64);
+    }
+  }
+}
+
+void Bitboard::store(Grid& grid, Color alive, Color dead,
+                     uint32_t numThreads)
+{
+  uint32_t a = alive.r | ((uint32_t)alive.g << 8) |
+               ((uint32_t)alive.b << 16) | ((uint32_t)alive.a << 24);
+  uint32_t d = dead.r | ((uint32_t)dead.g << 8) | ((uint32_t)dead.b << 16) |
+               ((uint32_t)dead.a << 24);
+  uint8_t* data = grid.getData();
+  auto storeRows = [&](uint64_t begin, uint64_t end) {
+    for (uint64_t row = begin; row < end; row++)
+    {
+      for (uint64_t col = 0; col < m_width; col++)
+      {
+        uint64_t word = m_cells[row * m_wordsPerRow + col / 64];
+        std::memcpy(data + (row * m_width + col) * 4,
+                    (word >> (col % 64)) & 1 ? &a : &d, 4);
+      }
+    }
+  };
+  automata::ThreadPool::getShared().forEachBand(m_height, numThreads,
+                                                storeRows);
+}
+
+bool Bitboard::getCell(uint64_t row, uint64_t col)
+{
+  return (m_cells[row * m_wordsPerRow + col / 64] >> (col % 64)) & 1;
+}
+
+void Bitboard::setCell(uint64_t row, uint64_t col, bool alive)
+{
+  if (row >= m_height || col >= m_width)
+    return;
+  uint64_t& word = m_cells[row * m_wordsPerRow + col / 64];
+  if (alive)
+    word |= 1ull << (col % 64);
+  else
+    word &= ~(1ull << (col % 64));
+}
+
+uint64_t Bitboard::getPopulation()
+{
+  uint64_t population = 0;
+  for (uint64_t word : m_cells)
+    population += popCount(word);
+  return population;
+}
+
+void Bitboard::setExtendedBit(uint64_t row, int64_t col)
+{
+  // column -64 is bit 0 of the left halo word
+  uint64_t bit = col + 64;
+  m_extended[row * (m_wordsPerRow + 2) + bit / 64] |= 1ull << (bit % 64);
+}
+
+void Bitboard::buildExtendedRows(bool wrap)
+{
+  uint64_t stride = m_wordsPerRow + 2;
+  std::fill(m_extended.begin(), m_extended.end(), 0);
+  for (uint64_t row = 0; row < m_height; row++)
+  {
+    std::memcpy(&m_extended[row * stride + 1], &m_cells[row * m_wordsPerRow],
+                m_wordsPerRow * sizeof(uint64_t));
+    if (!wrap)
+      continue;
+    // neighborhoods reach at most two columns past either edge
+    int64_t width = m_width;
+    for (int64_t col = -2; col < 0; col++)
+    {
+      if (getCell(row, ((col % width) + width) % width))
+        setExtendedBit(row, col);
+    }
+    for (int64_t col = width; col < width + 2; col++)
+    {
+      if (getCell(row, col % width))
+        setExtendedBit(row, col);
+    }
+  }
+}
+
+void Bitboard::step(Rule& rule, uint32_t neighborhoodSize, bool wrap,
+                    uint32_t numThreads)
+{
+  StepPlan plan;
+  plan.offsets = getNeighborhood(neighborhoodSize);
+  plan.countShift = getNeighborhoodDivisor(neighborhoodSize) == 2 ? 1 : 0;
+  plan.wrap = wrap;
+
+  uint32_t maxSum = 0;
+  for (const auto& offset : plan.offsets)
+    maxSum += offset.weight;
+  plan.numBits = 0;
+  while (plan.numBits < maxCounterBits && (1u << plan.numBits) <= maxSum)
+    plan.numBits++;
+  plan.maxCount = maxSum >> plan.countShift;
+
+  plan.birthMask = 0;
+  plan.surviveMask = 0;
+  for (uint8_t n : rule.m_birthConditions)
+    if (n <= plan.maxCount)
+      plan.birthMask |= 1ull << n;
+  for (uint8_t n : rule.m_surviveConditions)
+    if (n <= plan.maxCount)
+      plan.surviveMask |= 1ull << n;
+
+  buildExtendedRows(wrap);
+  automata::ThreadPool::getShared().forEachBand(
+    m_height, numThreads,
+    [&](uint64_t begin, uint64_t end) { stepRows(plan, begin, end); });
+  m_cells.swap(m_next);
+}
+
+void Bitboard::stepRows(const StepPlan& plan, int64_t begin, int64_t end)
+{
+  const std::vector<NeighborOffset>& offsets = plan.offsets;
+  uint64_t stride = m_wordsPerRow + 2;
+  int64_t height = m_height;
+  const uint64_t* emptyRow = &m_extended[m_height * stride];
+  std::vector<const uint64_t*> rows(offsets.size());
+
+  for (int64_t row = begin; row < end; row++)
+  {
+    for (size_t k = 0; k < offsets.size(); k++)
+    {
+      int64_t sourceRow = row + offsets[k].dy;
+      if (plan.wrap)
+        rows[k] = &m_extended[(((sourceRow % height) + height) % height) *
+                              stride];
+      else if (sourceRow < 0 || sourceRow >= height)
+        rows[k] = emptyRow;
+      else
+        rows[k] = &m_extended[sourceRow * stride];
+    }
+    const uint64_t* center = &m_extended[row * stride + 1];
+
+    for (uint64_t i = 0; i < m_wordsPerRow; i++)
+    {
+      uint64_t counter[maxCounterBits] = {0};
+      for (size_t k = 0; k < offsets.size(); k++)
+      {
+        const uint64_t* word = rows[k] + i + 1;
+        int32_t dx = offsets[k].dx;
+        uint64_t plane;
+        if (dx == 0)
+          plane = word[0];
+        else if (dx > 0)
+          plane = (word[0] >> dx) | (word[1] << (64 - dx));
+        else
+          plane = (word[0] << -dx) | (word[-1] >> (64 + dx));
+
+        // ripple the plane into the bit-sliced counter, a weight of two
+        // enters one bit up
+        uint64_t carry = plane;
+        for (uint32_t b = offsets[k].weight - 1; b < plan.numBits; b++)
+        {
+          uint64_t next = counter[b] & carry;
+          counter[b] ^= carry;
+          carry = next;
+        }
+      }
+
+      uint64_t born = 0;
+      uint64_t survived = 0;
+      uint64_t anyMask = plan.birthMask | plan.surviveMask;
+      for (uint32_t n = 0; n <= plan.maxCount; n++)
+      {
+        if (!(anyMask >> n & 1))
+          continue;
+        uint64_t match = ~0ull;
+        for (uint32_t b = plan.countShift; b < plan.numBits; b++)
+          match &=
+            (n >> (b - plan.countShift)) & 1 ? counter[b] : ~counter[b];
+        if (plan.birthMask >> n & 1)
+          born |= match;
+        if (plan.surviveMask >> n & 1)
+          survived |= match;
+      }
+
+      uint64_t alive = center[i];
+      uint64_t next = (alive & survived) | (~alive & born);
+      if (i == m_wordsPerRow - 1)
+        next &= m_lastWordMask;
+      m_next[row * m_wordsPerRow + i] = next;
+    }
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef AUTOMATA_BITBOARD
+#define AUTOMATA_BITBOARD
+
+#include "Grid.hpp"
+#include "Neighborhood.hpp"
+#include "Rule.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// life state packed 64 cells per word (bit n of word i is column 64 * i + n),
+// stepped with bit-sliced adders instead of per cell neighbor counts
+class Bitboard
+{
+public:
+  Bitboard(uint64_t width, uint64_t height);
+
+  // alive wherever the alpha band is set, like Grid::checkCell
+  void load(Grid& grid);
+
+  void store(Grid& grid, Color alive, Color dead, uint32_t numThreads);
+
+  // reads m_cells and writes m_next in numThreads horizontal bands, then
+  // swaps them
+  void step(Rule& rule, uint32_t neighborhoodSize, bool wrap,
+            uint32_t numThreads);
+
+  bool getCell(uint64_t row, uint64_t col);
+
+  void setCell(uint64_t row, uint64_t col, bool alive);
+
+  uint64_t getPopulation();
+
+private:
+  struct StepPlan
+  {
+    std::vector<NeighborOffset> offsets;
+    uint32_t countShift; // the weighted count starts at counter bit 1
+    uint32_t numBits;
+    uint32_t maxCount;
+    uint64_t birthMask;
+    uint64_t surviveMask;
+    bool wrap;
+  };
+
+  void stepRows(const StepPlan& plan, int64_t begin, int64_t end);
+
+  void buildExtendedRows(bool wrap);
+
+  void setExtendedBit(uint64_t row, int64_t col);
+
+  uint64_t m_width;
+  uint64_t m_height;
+  uint64_t m_wordsPerRow;
+  uint64_t m_lastWordMask; // clears the padding bits past m_width
+  std::vector<uint64_t> m_cells;
+  std::vector<uint64_t> m_next;
+  // every row with one halo word on each side, plus a trailing empty row
+  // that stands in for rows off the edge when not wrapping
+  std::vector<uint64_t> m_extended;
+};
+
+#endif
@@ -1,34 +1,62 @@
 #include "Conways.hpp"
 
-#include "imgui/imgui.h"
-#include "utils/LoadTextureFromData.hpp"
+#include "utils/Profiler.hpp"
+#include "utils/ThreadPool.hpp"
 
-#include <d3d11.h>
+#include <algorithm>
+#include <chrono>
 #include <random>
 #include <string>
+#include <thread>
+
+namespace
+{
+// cells per side of the tiles the byte cells engine skips when stable
+const uint64_t activityTileSize = 32;
+} // namespace
 
 Conways::Conways(uint64_t height, uint64_t width, uint32_t scale,
                  ID3D11Device* pDevice)
   : m_height(height),
     m_width(width),
     m_grid(width, height),
-    m_upsampledGrid(width * scale, height * scale),
     m_rule(std::set<uint8_t>{3}, std::set<uint8_t>{2, 3}),
     m_defaultRule(std::set<uint8_t>{3}, std::set<uint8_t>{2, 3}),
     m_scale(scale),
     m_neighborhoodSize(8),
     m_presetRules(),
     m_wrap(true),
-    m_pDevice(pDevice),
-    m_texture(NULL),
-    m_view(NULL)
+    m_numThreads(std::max(1u, std::thread::hardware_concurrency())),
+    m_engine(LifeEngine::ByteCells),
+    m_plane(width, height),
+    m_nextPlane(width, height),
+    m_activity(width, height, activityTileSize, CellPlane::margin),
+    m_lastRule(m_rule),
+    m_lastNeighborhoodSize(8),
+    m_lastWrap(true),
+    m_showActiveTiles(false),
+    m_simdLevel(std::min(automata::getSimdLevel(), automata::SimdLevel::Avx2)),
+    m_bitboard(width, height),
+    m_hashlife(512ull << 20),
+    m_hashlifeExponent(0),
+    m_viewLeft(-(int64_t)width / 2),
+    m_viewTop(-(int64_t)height / 2),
+    m_viewZoom(0),
+    m_engineStale(true),
+    m_lastStepMs(0),
+    m_pDevice(pDevice)
 {
-  loadGrid();
+  // the presenter is made the first time the window shows
+  m_grid.enableBackBuffer();
 
   m_presetRules.insert({"M1 Conway's game of life",
                         Rule{std::set<uint8_t>{3}, std::set<uint8_t>{2, 3}}});
   m_presetRules.insert({"M1 Islands", Rule{std::set<uint8_t>{5, 6, 7, 8},
                                            std::set<uint8_t>{4, 5, 6, 7, 8}}});
+  // an isotropic non-totalistic variant of life
+  Rule tlife(std::set<uint8_t>{}, std::set<uint8_t>{});
+  tlife.parse("B3/S2-i34q");
+  m_presetRules.insert({"M1 tlife", tlife});
   m_presetRules.insert(
     {"M2 Life",
      Rule{std::set<uint8_t>{8, 9, 10, 11, 12, 13},
@@ -52,371 +80,176 @@ Conways::Conways(uint64_t height, uint64_t width, uint32_t scale,
                                                15, 16}}}); // more flames
 }
 
-void Conways::showAutomataWindow()
-{
-  static int timer = 0;
-  static int timerReset = 0;
-  static bool displayRuleMenu = false;
-  static bool running = false;
-  static bool drawClick = false;
-
-  if (ImGui::Button("Show Rule Editor"))
-    displayRuleMenu = true;
-
-  if (displayRuleMenu)
-    showRuleMenu(displayRuleMenu);
-
-  ImGui::Checkbox("Wrap edges", &m_wrap);
-
-  if (ImGui::Button("Clear"))
-  {
-    m_grid.clear();
-    m_upsampledGrid.clear();
-    loadGrid();
-  }
-  ImGui::SameLine();
-  if (!running && ImGui::Button("Start"))
-  {
-   resetGrid();
-   running = true;
-  }
-  ImGui::SameLine();
-  if (running && ImGui::Button("Stop"))
-  {
-    running = false;
-  }
-  ImGui::SameLine();
-  if (!running && ImGui::Button("Step"))
-    updateGrid();
-  if (!running)
-  {
-    ImGui::SameLine();
-    if (ImGui::Button("Resume"))
-    {
-      updateGrid();
-      running = true;
-    }
-  }
-  ImGui::SliderInt("Simulation Speed", &timerReset, 0, 60);
-  if (timer > timerReset && running)
-  {
-    updateGrid();
-    timer = 0;
-  }
-  if (running)
-    timer++;
-
-   ImGui::Image((void*)m_view, ImVec2(m_grid.getWidth() * m_scale,
-                                      m_grid.getHeight() * m_scale));
-  
-  bool isHovered = ImGui::IsItemHovered();
-  ImVec2 mousePositionAbsolute = ImGui::GetMousePos();
-  ImVec2 screenPositionAbsolute = ImGui::GetItemRectMin();
-  ImVec2 mousePositionRelative =
-    ImVec2(mousePositionAbsolute.x - screenPositionAbsolute.x,
-           mousePositionAbsolute.y - screenPositionAbsolute.y);
-  if (ImGui::IsMouseDown(ImGuiMouseButton_Left) && isHovered &&
-      mousePositionRelative.x < m_scale * m_width &&
-      mousePositionRelative.x >= 0 &&
-      mousePositionRelative.y < m_scale * m_height &&
-      mousePositionRelative.y >= 0)
-  { // did the user click on the grid?
-    m_grid.setCell(mousePositionRelative.y / m_scale,
-                   mousePositionRelative.x / m_scale,
-                   Color{255, 255, 255, 255});
-    m_grid.applyChanges();
-    upsampleGrid(m_grid, m_upsampledGrid, m_scale);
-    loadGrid();
-  }
-  ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
-              1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-
-  ImDrawList* draw_list = ImGui::GetWindowDrawList();
-  draw_list->AddImage(m_view, ImVec2(1, 100), ImVec2(1, 100));
-  
-}
-
-void Conways::showRuleMenu(bool& show)
+void Conways::step()
 {
-  ImGuiWindowFlags flags = 0;
-  flags |= ImGuiWindowFlags_AlwaysAutoResize;
-  flags |= ImGuiWindowFlags_NoResize;
-  ImGui::Begin("Rule Editor", &show, flags);
+  automata::ProfileZone zone("Conways::step");
+  Color dead = {0, 0, 0, 0};
+  Color alive = {255, 255, 255, 255};
 
-  static int neighborhoodSelected = 0;
-  if (ImGui::Combo("Neighborhood Size", &neighborhoodSelected,
-                   "Moore distance 1\0"
-                   "Moore Distance 2\0"
-                   "Von Neumann 1\0"
-                   "Von Neumann 2\0"
-                   "Weighted\0\0"))
+  auto start = std::chrono::steady_clock::now();
+  if (m_engine == LifeEngine::Bitboard)
   {
-    switch (neighborhoodSelected)
+    // bit slicing only sees neighbor counts
+    if (m_rule.isTotalistic())
     {
-    case 0:
-      m_neighborhoodSize = 8;
-      break;
-    case 1:
-      m_neighborhoodSize = 24;
-      break;
-    case 2:
-      m_neighborhoodSize = 4;
-      break;
-    case 3:
-      m_neighborhoodSize = 12;
-      break;
-    case 4:
-      m_neighborhoodSize = 16;
+      if (m_engineStale)
+        m_bitboard.load(m_grid);
+      m_engineStale = false;
+      m_bitboard.step(m_rule, m_neighborhoodSize, m_wrap, m_numThreads);
+      m_bitboard.store(m_grid, alive, dead, m_numThreads);
     }
   }
-
-  if (ImGui::Button("Reset rule to default"))
-    m_rule = m_defaultRule;
-  if (ImGui::Button("Randomize Rule"))
+  else if (m_engine == LifeEngine::Hashlife)
   {
-    m_rule.m_birthConditions.clear();
-    m_rule.m_surviveConditions.clear();
-    for (uint32_t i = 0; i <= m_neighborhoodSize; i++)
+    if (m_neighborhoodSize == 8)
     {
-      if (rand() % 3 == 0)
-      {
-        m_rule.m_birthConditions.insert(i);
-      }
-      if (rand() % 3 == 0)
-      {
-        m_rule.m_surviveConditions.insert(i);
+      if (m_engineStale)
+      { // pick the pattern up from the grid, one cell per pixel
+        m_viewZoom = 0;
+        m_hashlife.clear();
+        m_hashlife.load(m_grid, m_viewLeft, m_viewTop);
       }
+      m_engineStale = false;
+      m_hashlife.setRule(m_rule);
+      m_hashlife.step(m_hashlifeExponent);
+      m_hashlife.render(m_grid, m_viewLeft, m_viewTop, m_viewZoom, alive);
     }
   }
-  if (ImGui::Button("Clear rule"))
-  {
-    m_rule = Rule(std::set<uint8_t>{}, std::set<uint8_t>{});
-  }
-  const char* items[] = {"M1 Conway's game of life",
-                         "M1 Islands",
-                         "M2 Life",
-                         "M2 fireworks",
-                         "M2 flames",
-                         "M2 little roads",
-                         "Weighted flames"};
-  static int item_current_idx = 0;
-  const char* combo_preview_value = items[item_current_idx];
-  if (ImGui::BeginCombo("Load Preset Rule", combo_preview_value))
+  else
   {
-    for (int n = 0; n < IM_ARRAYSIZE(items); n++)
-    {
-      const bool is_selected = (item_current_idx == n);
-      if (ImGui::Selectable(items[n], is_selected))
-      {
-        item_current_idx = n;
-        for (const auto& rule : m_presetRules)
+    auto& pool = automata::ThreadPool::getShared();
+    bool ruleChanged = m_rule != m_lastRule ||
+                       m_neighborhoodSize != m_lastNeighborhoodSize ||
+                       m_wrap != m_lastWrap;
+    if (m_engineStale || ruleChanged)
+    { // start over from the grid and recompute every tile once
+      auto loadRows = [&](uint64_t begin, uint64_t end) {
+        for (int64_t h = begin; h < (int64_t)end; h++)
         {
-          if (rule.first == items[item_current_idx])
-          {
-            m_rule = rule.second;
-          }
+          uint8_t* cells = m_plane.getRow(h);
+          for (int64_t w = 0; w < m_width; w++)
+            cells[w] = m_grid.checkCell(h, w);
         }
-      }
-      if (is_selected)
-        ImGui::SetItemDefaultFocus();
+      };
+      pool.forEachBand(m_height, m_numThreads, loadRows);
+      m_activity.markAllChanged();
+      m_lastRule = m_rule;
+      m_lastNeighborhoodSize = m_neighborhoodSize;
+      m_lastWrap = m_wrap;
     }
-    ImGui::EndCombo();
-  }
-  ImGui::Text("Click to toggle rules");
-  ImGui::Text("Birth Conditions:");
-  for (uint8_t i = 0; i <= m_neighborhoodSize; i++)
-  {
-    if (m_rule.m_birthConditions.count(i))
-      ImGui::PushStyleColor(ImGuiCol_Button,
-                            (ImVec4)ImColor::HSV(0.4f, 0.6f, 0.6f));
-    else
-      ImGui::PushStyleColor(ImGuiCol_Button,
-                            (ImVec4)ImColor::HSV(0.0f, 0.6f, 0.6f));
-    if (ImGui::Button((std::string("b") + std::to_string(i)).c_str()))
-    {
-      if (m_rule.m_birthConditions.count(i))
-        m_rule.m_birthConditions.erase(i);
-      else
-        m_rule.m_birthConditions.insert(i);
-    }
-    ImGui::PopStyleColor();
-    if (i != m_neighborhoodSize)
-      ImGui::SameLine();
-  }
-  ImGui::Text("Survival Conditions:");
-  for (uint8_t i = 0; i <= m_neighborhoodSize; i++)
-  {
-    if (m_rule.m_surviveConditions.count(i))
-      ImGui::PushStyleColor(ImGuiCol_Button,
-                            (ImVec4)ImColor::HSV(0.4f, 0.6f, 0.6f));
-    else
-      ImGui::PushStyleColor(ImGuiCol_Button,
-                            (ImVec4)ImColor::HSV(0.0f, 0.6f, 0.6f));
-    if (ImGui::Button((std::string("s") + std::to_string(i)).c_str()))
-    {
-      if (m_rule.m_surviveConditions.count(i))
-        m_rule.m_surviveConditions.erase(i);
-      else
-        m_rule.m_surviveConditions.insert(i);
-    }
-    ImGui::PopStyleColor();
-    if (i != m_neighborhoodSize)
-      ImGui::SameLine();
-  }
-
-  std::string ruleStr("Current Rule: {Birth: ");
-  for (const auto& rule : m_rule.m_birthConditions)
-  {
-    ruleStr += std::to_string(rule) + " ";
-  }
-  ruleStr += ", Survival: ";
-  for (const auto& rule : m_rule.m_surviveConditions)
-  {
-    ruleStr += std::to_string(rule) + " ";
-  }
-  ruleStr += "}";
-  ImGui::Text(ruleStr.c_str());
-  ImGui::End();
-}
-
-void Conways::loadGrid()
-{
-  if (m_texture)
-    m_texture->Release();
-  if (m_view)
-    m_view->Release();
-
-  automata::LoadTextureFromData(m_upsampledGrid.getData(), &m_view, &m_texture,
-                                m_pDevice, m_width * m_scale,
-                                m_height * m_scale);
+    m_plane.updateBorder(m_wrap);
+    m_activity.updateActive(m_wrap);
+
+    pool.forEachBand(m_activity.getTilesY(), m_numThreads,
+                     [&](uint64_t begin, uint64_t end) {
+                       stepTiles(begin, end);
+                     });
+    m_grid.swapBuffers();
+    std::swap(m_plane, m_nextPlane);
+    m_engineStale = false;
+  }
+  m_lastStepMs = std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
 }
 
-void Conways::updateGrid()
+void Conways::stepTiles(uint64_t begin, uint64_t end)
 {
   Color dead = {0, 0, 0, 0};
   Color alive = {255, 255, 255, 255};
+  uint64_t tileSize = m_activity.getTileSize();
+  std::vector<uint8_t> counts(tileSize);
+  std::vector<uint8_t> nextRow(tileSize);
+  // isotropic rules need the whole 3x3 block, totalistic ones only the count
+  bool usePatterns = m_neighborhoodSize == 8 && !m_rule.isTotalistic();
 
-  for (uint32_t h = 0; h < m_height; h++)
+  for (uint64_t ty = begin; ty < end; ty++)
   {
-    for (uint32_t w = 0; w < m_width; w++)
+    int64_t top = ty * tileSize;
+    int64_t bottom = std::min<int64_t>(top + tileSize, m_height);
+    for (uint64_t tx = 0; tx < m_activity.getTilesX(); tx++)
     {
-      uint32_t aliveNeighbors = countNeighbors(h, w);
-      if (m_grid.checkCell(h, w))
-      { // if the cell is alive
-        if (!m_rule.survived(aliveNeighbors))
+      // a stable tile already holds this generation in both buffers
+      if (!m_activity.isActive(tx, ty))
+        continue;
+      int64_t left = tx * tileSize;
+      int64_t right = std::min<int64_t>(left + tileSize, m_width);
+      bool changed = false;
+      for (int64_t h = top; h < bottom; h++)
+      {
+        const uint8_t* cells = m_plane.getRow(h);
+        uint8_t* nextCells = m_nextPlane.getRow(h);
+        if (usePatterns)
         {
-          m_grid.setCell(h, w, dead);
+          const uint8_t* above = m_plane.getRow(h - 1);
+          const uint8_t* below = m_plane.getRow(h + 1);
+          auto column = [&](int64_t w) {
+            return above[w] | (cells[w] << 1) | (below[w] << 2);
+          };
+          uint32_t pattern = (column(left - 1) << 3) | column(left);
+          for (int64_t w = left; w < right; w++)
+          {
+            pattern = ((pattern << 3) | column(w + 1)) & 0x1ff;
+            nextRow[w - left] = m_rule.next(pattern);
+          }
         }
-      }
-      else
-      { // is the cell is dead
-        if (m_rule.born(aliveNeighbors))
+        else
+        {
+          neighbors::countSpan(m_plane, h, left, right - left,
+                               m_neighborhoodSize, counts.data(),
+                               m_simdLevel);
+          for (int64_t w = left; w < right; w++)
+          {
+            uint8_t aliveNeighbors = counts[w - left];
+            nextRow[w - left] = cells[w] ? m_rule.survived(aliveNeighbors)
+                                         : m_rule.born(aliveNeighbors);
+          }
+        }
+        for (int64_t w = left; w < right; w++)
         {
-          m_grid.setCell(h, w, alive);
+          bool next = nextRow[w - left];
+          changed |= next != (bool)cells[w];
+          nextCells[w] = next;
+          m_grid.setBackCell(h, w, next ? alive : dead);
         }
       }
+      if (changed)
+        m_activity.markChanged(tx, ty);
     }
   }
-  m_grid.applyChanges();
-  upsampleGrid(m_grid, m_upsampledGrid, m_scale);
-  loadGrid();
 }
 
-void Conways::resetGrid()
+void Conways::randomize()
 {
   Color white{255, 255, 255, 255};
   m_grid.clear();
-  m_upsampledGrid.clear();
   for (uint32_t h = 0; h < m_height; h++)
   {
     for (uint32_t w = 0; w < m_width; w++)
     {
       if (rand() % 2 == 0)
       {
-        m_grid.setCell(h, w, white);
+        m_grid.setCellDirectly(h, w, white);
       }
     }
   }
-  m_grid.applyChanges();
-  upsampleGrid(m_grid, m_upsampledGrid, m_scale);
-  loadGrid();
+  m_engineStale = true;
 }
 
-uint32_t Conways::countNeighbors(int32_t height, int32_t width)
+void Conways::publish()
 {
-  if (m_neighborhoodSize == 8)
-    return checkCell(height - 1, width - 1) + checkCell(height - 1, width) +
-           checkCell(height - 1, width + 1) + checkCell(height, width - 1) +
-           checkCell(height, width + 1) + checkCell(height + 1, width - 1) +
-           checkCell(height + 1, width) + checkCell(height + 1, width + 1);
-  else if (m_neighborhoodSize == 24)
-    return checkCell(height - 1, width - 1) + checkCell(height - 1, width) +
-           checkCell(height - 1, width + 1) + checkCell(height, width - 1) +
-           checkCell(height, width + 1) + checkCell(height + 1, width - 1) +
-           checkCell(height + 1, width) + checkCell(height + 1, width + 1) +
-           checkCell(height - 2, width - 2) + checkCell(height - 2, width - 1) +
-           checkCell(height - 2, width) + checkCell(height - 2, width + 1) +
-           checkCell(height - 2, width + 2) + checkCell(height - 1, width - 2) +
-           checkCell(height - 1, width + 2) + checkCell(height, width - 2) +
-           checkCell(height, width + 2) + checkCell(height + 1, width - 2) +
-           checkCell(height + 1, width + 2) + checkCell(height + 2, width - 2) +
-           checkCell(height + 2, width - 1) + checkCell(height + 2, width) +
-           checkCell(height + 2, width + 1) + checkCell(height + 2, width + 2);
-  else if (m_neighborhoodSize == 4)
-    return checkCell(height - 1, width) + checkCell(height, width - 1) +
-           checkCell(height + 1, width) + checkCell(height, width + 1);
-  else if (m_neighborhoodSize == 12)
-    return checkCell(height - 2, width) + checkCell(height - 1, width - 1) +
-           checkCell(height - 1, width) + checkCell(height - 1, width + 1) +
-           checkCell(height, width - 2) + checkCell(height, width - 1) +
-           checkCell(height, width + 1) + checkCell(height, width + 2) +
-           checkCell(height + 1, width - 1) + checkCell(height + 1, width) +
-           checkCell(height + 1, width + 1) + checkCell(height + 2, width);
-  else if (m_neighborhoodSize == 16) // inner 8 cells have twice the weight
-    return (2 * checkCell(height - 1, width - 1) +
-            2 * checkCell(height - 1, width) +
-            2 * checkCell(height - 1, width + 1) +
-            2 * checkCell(height, width - 1) +
-            2 * checkCell(height, width + 1) +
-            2 * checkCell(height + 1, width - 1) +
-            2 * checkCell(height + 1, width) +
-            2 * checkCell(height + 1, width + 1) +
-            checkCell(height - 2, width - 2) +
-            checkCell(height - 2, width - 1) + checkCell(height - 2, width) +
-            checkCell(height - 2, width + 1) +
-            checkCell(height - 2, width + 2) +
-            checkCell(height - 1, width - 2) +
-            checkCell(height - 1, width + 2) + checkCell(height, width - 2) +
-            checkCell(height, width + 2) + checkCell(height + 1, width - 2) +
-            checkCell(height + 1, width + 2) +
-            checkCell(height + 2, width - 2) +
-            checkCell(height + 2, width - 1) + checkCell(height + 2, width) +
-            checkCell(height + 2, width + 1) +
-            checkCell(height + 2, width + 2)) /
-           2;
-  else
-    return 0;
+  if (m_presenter)
+    m_presenter->publish(m_grid);
 }
 
-bool Conways::checkCell(int32_t row, int32_t col)
+void Conways::updateGrid()
 {
-  int32_t r = row;
-  int32_t c = col;
-  if (m_wrap)
-  {
-    if (row <= -1)
-      r = m_height + row;
-    if (row >= m_height)
-      r = row - m_height;
-    if (col <= -1)
-      c = m_width + col;
-    if (col >= m_width)
-      c = col - m_width;
-  }
-  else
-  {
-    if (row < 0 || row >= m_height || col < 0 || col >= m_width)
-      return false;
-  }
-  return m_grid.checkCell(r, c);
+  step();
+  publish();
+}
+
+void Conways::resetGrid()
+{
+  randomize();
+  publish();
 }
@@ -1,30 +1,25 @@
 #ifndef AUTOMATA_CONWAYS
 #define AUTOMATA_CONWAYS
 
+#include "Bitboard.hpp"
 #include "Grid.hpp"
+#include "Hashlife.hpp"
+#include "NeighborKernel.hpp"
+#include "Presenter.hpp"
+#include "Rule.hpp"
+#include "TileActivity.hpp"
+#include "utils/D3D11Forward.hpp"
 
-#include <d3d11.h>  
-#include <set>
+#include <algorithm>
 #include <map>
+#include <memory>
+#include <set>
 
-struct Rule
+enum class LifeEngine
 {
-  Rule(std::set<uint8_t>& birthConditions,
-       std::set<uint8_t>& surviveConditions)
-    : m_birthConditions(birthConditions), m_surviveConditions(surviveConditions)
-  {}
-
-  bool survived(uint8_t neighbors)
-  {
-    return m_surviveConditions.count(neighbors);
-  }
-
-  bool born(uint8_t neighbors)
-  {
-    return m_birthConditions.count(neighbors);
-  }
-  std::set<uint8_t> m_birthConditions;
-  std::set<uint8_t> m_surviveConditions;
+  ByteCells,
+  Bitboard,
+  Hashlife
 };
 
 class Conways {
@@ -36,30 +31,108 @@ public:
 
   void showRuleMenu(bool& show);
 
-  void loadGrid();
+  void showHashlifeOptions();
+
+  // one band of tile rows of the byte cells engine, reads m_plane and writes
+  // the active tiles of m_nextPlane and the back buffer of m_grid
+  void stepTiles(uint64_t begin, uint64_t end);
 
+  // hands m_grid to the presenter, if there is one yet
+  void publish();
+
+  void setPresenter(std::unique_ptr<Presenter> presenter)
+  {
+    m_presenter = std::move(presenter);
+  }
+
+  // step, then publishes the new generation
   void updateGrid();
 
+  // randomize, then publishes it
   void resetGrid();
 
-  uint32_t countNeighbors(int32_t height, int32_t width);
+  // one generation of the current engine into m_grid, nothing is published
+  void step();
+
+  // every cell alive or dead at random
+  void randomize();
+
+  void setEngine(LifeEngine engine)
+  {
+    m_engine = engine;
+    m_engineStale = true;
+  }
+
+  void setRule(const Rule& rule, uint32_t neighborhoodSize)
+  {
+    m_rule = rule;
+    m_neighborhoodSize = neighborhoodSize;
+  }
+
+  void setNumThreads(uint32_t numThreads)
+  {
+    m_numThreads = numThreads;
+  }
+
+  // of the byte cells kernel, there is none past avx2
+  void setSimdLevel(automata::SimdLevel level)
+  {
+    m_simdLevel = std::min(level, automata::SimdLevel::Avx2);
+  }
 
-  bool checkCell(int32_t row, int32_t col);
+  // generations per step of the hashlife engine, as a power of two
+  void setHashlifeExponent(int exponent)
+  {
+    m_hashlifeExponent = exponent;
+  }
+
+  Grid& getGrid()
+  {
+    return m_grid;
+  }
+
+  double getLastStepMs()
+  {
+    return m_lastStepMs;
+  }
 
 private:
   int64_t m_height;
   int64_t m_width;
   Grid m_grid;
-  Grid m_upsampledGrid;
   Rule m_rule;
   Rule m_defaultRule;
   uint32_t m_scale;
   uint32_t m_neighborhoodSize;
   std::map<std::string, Rule> m_presetRules;
   bool m_wrap;
+  uint32_t m_numThreads; // horizontal bands stepped in parallel
+  LifeEngine m_engine;
+  // this and the previous generation, a stable tile holds the same cells in
+  // both so it is never written
+  CellPlane m_plane;
+  CellPlane m_nextPlane;
+  TileActivity m_activity;
+  // what the byte cells engine last stepped with, changing any of them can
+  // wake up stable tiles
+  Rule m_lastRule;
+  uint32_t m_lastNeighborhoodSize;
+  bool m_lastWrap;
+  bool m_showActiveTiles;
+  automata::SimdLevel m_simdLevel;
+  Bitboard m_bitboard;
+  Hashlife m_hashlife;
+  int m_hashlifeExponent; // generations per step, as a power of two
+  // the part of the hashlife universe shown in m_grid, 2^m_viewZoom cells
+  // per pixel
+  int64_t m_viewLeft;
+  int64_t m_viewTop;
+  int m_viewZoom;
+  // m_grid was edited behind the back of the engine
+  bool m_engineStale;
+  double m_lastStepMs;
   ID3D11Device* m_pDevice;
-  ID3D11ShaderResourceView* m_view;
-  ID3D11Texture2D* m_texture;
+  std::unique_ptr<Presenter> m_presenter;
 };
 
 #endif
\ No newline at end of file
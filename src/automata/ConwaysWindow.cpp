@@ -0,0 +1,380 @@
+#include "Conways.hpp"
+#include "TexturePresenter.hpp"
+
+#include "imgui/imgui.h"
+#include "utils/Profiler.hpp"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+void Conways::showAutomataWindow()
+{
+  automata::ProfileZone zone("Conways::showAutomataWindow");
+  static int timer = 0;
+  static int timerReset = 0;
+  static bool displayRuleMenu = false;
+  static bool running = false;
+  static bool drawClick = false;
+
+  if (!m_presenter)
+  {
+    setPresenter(std::unique_ptr<Presenter>(new TexturePresenter(m_pDevice)));
+    publish();
+  }
+
+  if (ImGui::Button("Show Rule Editor"))
+    displayRuleMenu = true;
+
+  if (displayRuleMenu)
+    showRuleMenu(displayRuleMenu);
+
+  ImGui::Checkbox("Wrap edges", &m_wrap);
+
+  int numThreads = m_numThreads;
+  if (ImGui::SliderInt("Threads", &numThreads, 1,
+                       std::max(1u, std::thread::hardware_concurrency())))
+    m_numThreads = numThreads;
+
+  int engineIdx = (int)m_engine;
+  if (ImGui::Combo("Engine", &engineIdx,
+                   "Byte cells\0Bitboard\0HashLife\0\0"))
+  {
+    m_engine = (LifeEngine)engineIdx;
+    m_engineStale = true;
+  }
+  if (m_engine == LifeEngine::ByteCells)
+  {
+    // only offer the levels this cpu can run, there is no avx-512 kernel
+    const char* levels[] = {"Scalar", "SSE4.1", "AVX2"};
+    int levelIdx = (int)m_simdLevel;
+    int numLevels = std::min((int)automata::getSimdLevel(), 2) + 1;
+    if (ImGui::Combo("Kernel", &levelIdx, levels, numLevels))
+      m_simdLevel = (automata::SimdLevel)levelIdx;
+    ImGui::Checkbox("Show active tiles", &m_showActiveTiles);
+  }
+  if (m_engine == LifeEngine::Bitboard && !m_rule.isTotalistic())
+    ImGui::Text("Bitboard only runs totalistic rules");
+  if (m_engine == LifeEngine::Hashlife)
+    showHashlifeOptions();
+
+  if (ImGui::Button("Clear"))
+  {
+    m_grid.clear();
+    m_engineStale = true;
+    publish();
+  }
+  ImGui::SameLine();
+  if (!running && ImGui::Button("Start"))
+  {
+   resetGrid();
+   running = true;
+  }
+  ImGui::SameLine();
+  if (running && ImGui::Button("Stop"))
+  {
+    running = false;
+  }
+  ImGui::SameLine();
+  if (!running && ImGui::Button("Step"))
+    updateGrid();
+  if (!running)
+  {
+    ImGui::SameLine();
+    if (ImGui::Button("Resume"))
+    {
+      updateGrid();
+      running = true;
+    }
+  }
+  ImGui::SliderInt("Simulation Speed", &timerReset, 0, 60);
+  if (timer > timerReset && running)
+  {
+    updateGrid();
+    timer = 0;
+  }
+  if (running)
+    timer++;
+
+  m_presenter->present(m_scale);
+  
+  bool isHovered = ImGui::IsItemHovered();
+  ImVec2 mousePositionAbsolute = ImGui::GetMousePos();
+  ImVec2 screenPositionAbsolute = ImGui::GetItemRectMin();
+  ImVec2 mousePositionRelative =
+    ImVec2(mousePositionAbsolute.x - screenPositionAbsolute.x,
+           mousePositionAbsolute.y - screenPositionAbsolute.y);
+  if (ImGui::IsMouseDown(ImGuiMouseButton_Left) && isHovered &&
+      mousePositionRelative.x < m_scale * m_width &&
+      mousePositionRelative.x >= 0 &&
+      mousePositionRelative.y < m_scale * m_height &&
+      mousePositionRelative.y >= 0)
+  { // did the user click on the grid?
+    uint64_t row = mousePositionRelative.y / m_scale;
+    uint64_t col = mousePositionRelative.x / m_scale;
+    if (m_engine == LifeEngine::Hashlife && !m_engineStale)
+    {
+      // draw into the universe, a zoomed out pixel is not a single cell
+      if (m_viewZoom == 0)
+      {
+        m_hashlife.setCell(m_viewLeft + col, m_viewTop + row, true);
+        m_hashlife.render(m_grid, m_viewLeft, m_viewTop, m_viewZoom,
+                          Color{255, 255, 255, 255});
+      }
+    }
+    else
+    {
+      m_grid.setCell(row, col, Color{255, 255, 255, 255});
+      m_grid.applyChanges();
+      m_engineStale = true;
+    }
+    publish();
+  }
+  if (m_engine == LifeEngine::ByteCells && m_showActiveTiles)
+  {
+    ImDrawList* overlay = ImGui::GetWindowDrawList();
+    float tile = (float)(m_activity.getTileSize() * m_scale);
+    for (uint64_t ty = 0; ty < m_activity.getTilesY(); ty++)
+    {
+      for (uint64_t tx = 0; tx < m_activity.getTilesX(); tx++)
+      {
+        if (!m_activity.isActive(tx, ty))
+          continue;
+        ImVec2 min(screenPositionAbsolute.x + tx * tile,
+                   screenPositionAbsolute.y + ty * tile);
+        ImVec2 max(std::min(min.x + tile,
+                            screenPositionAbsolute.x + m_width * m_scale),
+                   std::min(min.y + tile,
+                            screenPositionAbsolute.y + m_height * m_scale));
+        overlay->AddRectFilled(min, max, IM_COL32(255, 64, 64, 48));
+      }
+    }
+    ImGui::Text("Active tiles %.1f%%",
+                100.0 * m_activity.getActiveFraction());
+  }
+  ImGui::Text("Last step %.3f ms", m_lastStepMs);
+  ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
+              1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+}
+
+void Conways::showHashlifeOptions()
+{
+  if (m_neighborhoodSize != 8)
+    ImGui::Text("HashLife only runs Moore distance 1 rules");
+  ImGui::SliderInt("Step size (2^n generations)", &m_hashlifeExponent, 0, 40);
+
+  bool viewChanged = false;
+  int zoom = m_viewZoom;
+  if (ImGui::SliderInt("Zoom out (2^n cells per pixel)", &zoom, 0, 40))
+  {
+    // keep the centre of the view in place
+    int64_t centerX = m_viewLeft + (m_width << m_viewZoom) / 2;
+    int64_t centerY = m_viewTop + (m_height << m_viewZoom) / 2;
+    m_viewZoom = zoom;
+    m_viewLeft = centerX - (m_width << m_viewZoom) / 2;
+    m_viewTop = centerY - (m_height << m_viewZoom) / 2;
+    viewChanged = true;
+  }
+  viewChanged |=
+    ImGui::InputScalar("View left", ImGuiDataType_S64, &m_viewLeft);
+  viewChanged |=
+    ImGui::InputScalar("View top", ImGuiDataType_S64, &m_viewTop);
+  if (viewChanged && !m_engineStale)
+  {
+    m_hashlife.render(m_grid, m_viewLeft, m_viewTop, m_viewZoom,
+                      Color{255, 255, 255, 255});
+    publish();
+  }
+
+  static int memoryLimitMb = 512;
+  if (ImGui::SliderInt("Memory limit (MB)", &memoryLimitMb, 16, 8192))
+    m_hashlife.setMemoryLimit((uint64_t)memoryLimitMb << 20);
+  if (ImGui::Button("Collect garbage"))
+    m_hashlife.collectGarbage();
+
+  HashlifeStats stats = m_hashlife.getStats();
+  ImGui::Text("Generation %llu, population %llu",
+              (unsigned long long)m_hashlife.getGeneration(),
+              (unsigned long long)m_hashlife.getPopulation());
+  ImGui::Text("Nodes: %llu live, %llu reserved, %llu buckets",
+              (unsigned long long)stats.liveNodes,
+              (unsigned long long)stats.reservedNodes,
+              (unsigned long long)stats.buckets);
+  ImGui::Text("Memory: %.1f of %.1f MB", stats.memoryUsed / 1048576.0,
+              stats.memoryLimit / 1048576.0);
+  ImGui::Text("Lookup hits %.1f%%, memoized successors %.1f%%",
+              stats.lookups ? 100.0 * stats.lookupHits / stats.lookups : 0.0,
+              stats.resultHits + stats.resultMisses
+                ? 100.0 * stats.resultHits /
+                    (stats.resultHits + stats.resultMisses)
+                : 0.0);
+  ImGui::Text("Collections: %llu, last freed %llu nodes",
+              (unsigned long long)stats.collections,
+              (unsigned long long)stats.lastCollected);
+}
+
+void Conways::showRuleMenu(bool& show)
+{
+  ImGuiWindowFlags flags = 0;
+  flags |= ImGuiWindowFlags_AlwaysAutoResize;
+  flags |= ImGuiWindowFlags_NoResize;
+  ImGui::Begin("Rule Editor", &show, flags);
+
+  static int neighborhoodSelected = 0;
+  if (ImGui::Combo("Neighborhood Size", &neighborhoodSelected,
+                   "Moore distance 1\0"
+                   "Moore Distance 2\0"
+                   "Von Neumann 1\0"
+                   "Von Neumann 2\0"
+                   "Weighted\0\0"))
+  {
+    switch (neighborhoodSelected)
+    {
+    case 0:
+      m_neighborhoodSize = 8;
+      break;
+    case 1:
+      m_neighborhoodSize = 24;
+      break;
+    case 2:
+      m_neighborhoodSize = 4;
+      break;
+    case 3:
+      m_neighborhoodSize = 12;
+      break;
+    case 4:
+      m_neighborhoodSize = 16;
+    }
+  }
+
+  bool conditionsChanged = false;
+  if (ImGui::Button("Reset rule to default"))
+    m_rule = m_defaultRule;
+  if (ImGui::Button("Randomize Rule"))
+  {
+    m_rule.m_birthConditions.clear();
+    m_rule.m_surviveConditions.clear();
+    m_rule.m_birthIsotropic.clear();
+    m_rule.m_surviveIsotropic.clear();
+    conditionsChanged = true;
+    for (uint32_t i = 0; i <= m_neighborhoodSize; i++)
+    {
+      if (rand() % 3 == 0)
+      {
+        m_rule.m_birthConditions.insert(i);
+      }
+      if (rand() % 3 == 0)
+      {
+        m_rule.m_surviveConditions.insert(i);
+      }
+    }
+  }
+  if (ImGui::Button("Clear rule"))
+  {
+    m_rule = Rule(std::set<uint8_t>{}, std::set<uint8_t>{});
+  }
+  const char* items[] = {"M1 Conway's game of life",
+                         "M1 Islands",
+                         "M1 tlife",
+                         "M2 Life",
+                         "M2 fireworks",
+                         "M2 flames",
+                         "M2 little roads",
+                         "Weighted flames"};
+  static int item_current_idx = 0;
+  const char* combo_preview_value = items[item_current_idx];
+  if (ImGui::BeginCombo("Load Preset Rule", combo_preview_value))
+  {
+    for (int n = 0; n < IM_ARRAYSIZE(items); n++)
+    {
+      const bool is_selected = (item_current_idx == n);
+      if (ImGui::Selectable(items[n], is_selected))
+      {
+        item_current_idx = n;
+        for (const auto& rule : m_presetRules)
+        {
+          if (rule.first == items[item_current_idx])
+          {
+            m_rule = rule.second;
+          }
+        }
+      }
+      if (is_selected)
+        ImGui::SetItemDefaultFocus();
+    }
+    ImGui::EndCombo();
+  }
+  ImGui::Text("Click to toggle rules");
+  ImGui::Text("Birth Conditions:");
+  for (uint8_t i = 0; i <= m_neighborhoodSize; i++)
+  {
+    if (m_rule.m_birthConditions.count(i))
+      ImGui::PushStyleColor(ImGuiCol_Button,
+                            (ImVec4)ImColor::HSV(0.4f, 0.6f, 0.6f));
+    else
+      ImGui::PushStyleColor(ImGuiCol_Button,
+                            (ImVec4)ImColor::HSV(0.0f, 0.6f, 0.6f));
+    if (ImGui::Button((std::string("b") + std::to_string(i)).c_str()))
+    {
+      if (m_rule.m_birthConditions.count(i))
+        m_rule.m_birthConditions.erase(i);
+      else
+        m_rule.m_birthConditions.insert(i);
+      conditionsChanged = true;
+    }
+    ImGui::PopStyleColor();
+    if (i != m_neighborhoodSize)
+      ImGui::SameLine();
+  }
+  ImGui::Text("Survival Conditions:");
+  for (uint8_t i = 0; i <= m_neighborhoodSize; i++)
+  {
+    if (m_rule.m_surviveConditions.count(i))
+      ImGui::PushStyleColor(ImGuiCol_Button,
+                            (ImVec4)ImColor::HSV(0.4f, 0.6f, 0.6f));
+    else
+      ImGui::PushStyleColor(ImGuiCol_Button,
+                            (ImVec4)ImColor::HSV(0.0f, 0.6f, 0.6f));
+    if (ImGui::Button((std::string("s") + std::to_string(i)).c_str()))
+    {
+      if (m_rule.m_surviveConditions.count(i))
+        m_rule.m_surviveConditions.erase(i);
+      else
+        m_rule.m_surviveConditions.insert(i);
+      conditionsChanged = true;
+    }
+    ImGui::PopStyleColor();
+    if (i != m_neighborhoodSize)
+      ImGui::SameLine();
+  }
+
+  std::string ruleStr("Current Rule: {Birth: ");
+  for (const auto& rule : m_rule.m_birthConditions)
+  {
+    ruleStr += std::to_string(rule) + " ";
+  }
+  ruleStr += ", Survival: ";
+  for (const auto& rule : m_rule.m_surviveConditions)
+  {
+    ruleStr += std::to_string(rule) + " ";
+  }
+  ruleStr += "}";
+  ImGui::Text(ruleStr.c_str());
+  if (conditionsChanged)
+    m_rule.compile();
+
+  // isotropic non-totalistic rules can only be typed in
+  static char henselText[64] = "B3/S23";
+  static bool henselError = false;
+  ImGui::InputText("Hensel notation", henselText, sizeof(henselText));
+  ImGui::SameLine();
+  if (ImGui::Button("Apply"))
+    henselError = !m_rule.parse(henselText);
+  if (henselError)
+    ImGui::Text("Not a B/S rule in Hensel notation");
+  if (m_neighborhoodSize == 8)
+    ImGui::Text("As Hensel notation: %s", m_rule.toString().c_str());
+  else if (!m_rule.isTotalistic())
+    ImGui::Text("Isotropic conditions only apply to Moore distance 1");
+  ImGui::End();
+}
@@ -1,9 +1,7 @@
 #include "Elementary.hpp"
 
-#include "imgui/imgui.h"
-#include "utils/LoadTextureFromData.hpp"
+#include "utils/Profiler.hpp"
 
-#include <d3d11.h>
 #include <random>
 
 Elementary::Elementary(uint64_t height, uint64_t width, uint32_t scale,
@@ -12,46 +10,16 @@ Elementary::Elementary(uint64_t height, uint64_t width, uint32_t scale,
     m_width(width),
     m_rule(30),
     m_grid(width, height),
-    m_upsampledGrid(width * scale, height * scale),
-    m_upsampledSize(4 * m_width * m_scale * m_height * m_scale),
     m_scale(scale),
-    m_pDevice(pDevice),
-    m_view(NULL),
-    m_texture(NULL)
+    m_pDevice(pDevice)
 {
-  updateTexture(true, true);
-  automata::LoadTextureFromData(m_upsampledGrid.getData(), &m_view, &m_texture,
-                                pDevice, m_width * m_scale, m_height * m_scale);
-}
-
-void Elementary::showAutomataWindow()
-{
-  static bool randomInit = true;
-  static bool wrap = true;
-
-  if (ImGui::Checkbox("Random Start", &randomInit))
-  {
-    updateTexture(wrap, randomInit);
-  }
-
-  if (ImGui::Checkbox("Wrap", &wrap))
-  {
-    updateTexture(wrap, randomInit);
-  }
-
-  if (ImGui::InputInt("Rule", &m_rule))
-  {
-    updateTexture(wrap, randomInit);
-  }
-
-  ImGui::Image((void*)m_view, ImVec2(m_grid.getWidth() * m_scale,
-                                     m_grid.getHeight() * m_scale));
-  ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
-              1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+  // the presenter is made the first time the window shows
+  updateGrid(true, true);
 }
 
 void Elementary::updateGrid(bool randInit, bool wrap)
 {
+  automata::ProfileZone zone("Elementary::updateGrid");
   Color white{255, 255, 255, 255};
   m_grid.clear();
   if (randInit)
@@ -60,15 +28,14 @@ void Elementary::updateGrid(bool randInit, bool wrap)
     {
       if (rand() % 2 == 1)
       {
-        m_grid.setCell(0, i, white);
+        m_grid.setCellDirectly(0, i, white);
       }
     }
   }
   else
   {
-    m_grid.setCell(0, m_width / 2, white);
+    m_grid.setCellDirectly(0, m_width / 2, white);
   }
-  m_grid.applyChanges();
 
   for (uint32_t row = 1; row < m_height; row++)
   {
@@ -87,31 +54,12 @@ void Elementary::updateGrid(bool randInit, bool wrap)
           left && middle && !right && (m_rule & 64) ||
           left && middle && right && (m_rule & 128))
       {
-        m_grid.setCell(row, col, white);
+        m_grid.setCellDirectly(row, col, white);
       }
     }
-    m_grid.applyChanges();
   }
 }
 
-void Elementary::updateTexture(bool wrap, bool rand)
-{
-  updateGrid(rand, wrap);
-  upsampleGrid(m_grid, m_upsampledGrid, m_scale);
-  if (m_view)
-  {
-    m_view->Release();
-  }
-  if (m_texture)
-  {
-    m_texture->Release();
-  }
-
-  automata::LoadTextureFromData(m_upsampledGrid.getData(), &m_view, &m_texture,
-                                m_pDevice, m_width * m_scale,
-                                m_height * m_scale);
-}
-
 bool Elementary::checkCell(uint32_t row, uint32_t col, bool wrap)
 {
   if (wrap)
@@ -132,3 +80,15 @@ bool Elementary::checkCell(uint32_t row, uint32_t col, bool wrap)
     return m_grid.checkCell(row, col);
   }
 }
+
+void Elementary::publish()
+{
+  if (m_presenter)
+    m_presenter->publish(m_grid);
+}
+
+void Elementary::updateTexture(bool wrap, bool rand)
+{
+  updateGrid(rand, wrap);
+  publish();
+}
@@ -2,7 +2,10 @@
 #define AUTOMATA_ELEMENTARY
 
 #include "Grid.hpp"
-#include <d3d11.h>
+#include "Presenter.hpp"
+#include "utils/D3D11Forward.hpp"
+
+#include <memory>
 
 class Elementary
 {
@@ -11,23 +14,41 @@ public:
 
   void showAutomataWindow();
 
+  // hands m_grid to the presenter, if there is one yet
+  void publish();
+
+  void setPresenter(std::unique_ptr<Presenter> presenter)
+  {
+    m_presenter = std::move(presenter);
+  }
+
+  // every row of m_grid from the one above it, the first row random or a
+  // single cell in the middle
   void updateGrid(bool randInit, bool wrap);
 
+  // updateGrid, then publishes it
   void updateTexture(bool wrap, bool rand);
 
   bool checkCell(uint32_t row, uint32_t col, bool wrap);
 
+  void setRule(int rule)
+  {
+    m_rule = rule;
+  }
+
+  Grid& getGrid()
+  {
+    return m_grid;
+  }
+
 private:
   uint64_t m_height;
   uint64_t m_width;
   int m_rule;
   Grid m_grid;
-  Grid m_upsampledGrid;
-  uint64_t m_upsampledSize;
   uint32_t m_scale;
   ID3D11Device *m_pDevice;
-  ID3D11ShaderResourceView *m_view;
-  ID3D11Texture2D *m_texture;
+  std::unique_ptr<Presenter> m_presenter;
 };
 
 #endif
@@ -0,0 +1,37 @@
+#include "Elementary.hpp"
+#include "TexturePresenter.hpp"
+
+#include "imgui/imgui.h"
+#include "utils/Profiler.hpp"
+
+void Elementary::showAutomataWindow()
+{
+  automata::ProfileZone zone("Elementary::showAutomataWindow");
+  static bool randomInit = true;
+  static bool wrap = true;
+
+  if (!m_presenter)
+  {
+    setPresenter(std::unique_ptr<Presenter>(new TexturePresenter(m_pDevice)));
+    publish();
+  }
+
+  if (ImGui::Checkbox("Random Start", &randomInit))
+  {
+    updateTexture(wrap, randomInit);
+  }
+
+  if (ImGui::Checkbox("Wrap", &wrap))
+  {
+    updateTexture(wrap, randomInit);
+  }
+
+  if (ImGui::InputInt("Rule", &m_rule))
+  {
+    updateTexture(wrap, randomInit);
+  }
+
+  m_presenter->present(m_scale);
+  ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
+              1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+}
@@ -1,13 +1,11 @@
 #include "Fractal.hpp"
-#include "Julia.hpp"
-#include "Mandelbrot.hpp"
+#include "FractalKernel.hpp"
 
-#include "imgui/imgui.h"
-#include "utils/LoadTextureFromData.hpp"
+#include "utils/Profiler.hpp"
 
-#include <d3d11.h>
-#include <future>
-#include <string>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace
 {
@@ -24,357 +22,390 @@ double normalizeIteration(double input)
 {
   return (input * log(input + 1)) / sqrt(input);
 }
-} // namespace
 
-namespace fractal
+template <typename Number>
+void calculateDeepSpan(const FractalInfo& f, const fractal::SpanArgs& args,
+                       double* out)
 {
-Palette updatePalette(std::vector<Color> colorList, const uint32_t numColors)
-{
-  auto p = Palette(colorList, numColors);
-  return p;
+  Number centerX(f.deepZoom.centerX);
+  Number centerY(f.deepZoom.centerY);
+  bool julia = f.type == FractalType::Julia;
+  double attracted = fractal::getAttractedDerivative(args.pixelSize);
+  uint64_t resolvedEarly = 0;
+  for (uint32_t i = 0; i < args.count; i++)
+  {
+    Number x = centerX + Number(args.x[i]);
+    Number y = centerY + Number(fractal::getPointY(args, i));
+    fractal::Escape escape =
+      julia ? fractal::iterateNumber(Number(f.seedX), Number(f.seedY), x, y,
+                                     args.smooth, args.maxIterations, true,
+                                     args.interiorChecks, attracted)
+            : fractal::iterateNumber(x, y, Number(0), Number(0), args.smooth,
+                                     args.maxIterations, false,
+                                     args.interiorChecks, attracted);
+    out[i] = fractal::getEscapeValue(escape, args.smooth, args.maxIterations);
+    resolvedEarly += escape.early;
+  }
+  if (args.resolvedEarly)
+    *args.resolvedEarly += resolvedEarly;
 }
-void showAutomataWindow(ID3D11Device* pDevice)
-{
-  std::vector<Color> initialColors = {
-    Color{0, 0, 0, 255}, Color{255, 255, 255, 255}};
-  static Grid grid(1000, 500);
-  static Smooth smooth = Smooth::Logarithmic;
-  static uint32_t numThreads(std::thread::hardware_concurrency());
-  static int numSteps = 100;
-  static int numPaletteColors = 2;
-  static Palette palette(initialColors, numSteps);
-  static float minDistance = 0.01f;
-  static int iterations = 1000;
-  static Int2 imageSize{1000, 500};
-  static ID3D11ShaderResourceView* pView = NULL;
-  static ID3D11Texture2D* pTexture = NULL;
-  static ImVec4 setColor = {0, 0, 0, 1};
-  static ImVec4 distanceColor = {1, 1, 1, 1};
-  static FractalType type = FractalType::Mandelbrot;
-  static FractalBounds window{-2.0, 2.0, -1.0, 1.0};
-  static float seedX = -1.0;
-  static float seedY = 0.0;
 
-  static FractalInfo f{&grid,       smooth,     numThreads, &palette,
-                       minDistance, iterations, imageSize,  &pView,
-                       &pTexture,   pDevice,    setColor,   distanceColor,
-                       type,        window,     seedX,      seedY};
-
-  static bool displayRuleMenu = false;
-
-  static uint32_t mouseX;
-  static uint32_t mouseY;
-
-  static bool updateView = true;
-  static bool debug = true;
+// points given as offsets from the deep zoom center, without a reference
+// orbit
+void calculateDeepSpan(const FractalInfo& f, const fractal::SpanArgs& args,
+                       double* out)
+{
+  switch (f.deepZoom.numberType)
+  {
+  // deep zooms start past what doubles resolve, see deepZoomStart
+  case automata::NumberType::Double:
+  case automata::NumberType::DoubleDouble:
+    calculateDeepSpan<automata::DoubleDouble>(f, args, out);
+    break;
+  case automata::NumberType::QuadDouble:
+    calculateDeepSpan<automata::QuadDouble>(f, args, out);
+    break;
+  case automata::NumberType::BigFixed:
+    calculateDeepSpan<automata::BigFixed>(f, args, out);
+    break;
+  }
+}
 
-  const char* smoothList[] = {"None", "Linear", "Logarithmic",
-                              "Distance Estimate"};
-  static int smoothIdx = (int)smooth;
-  static int numInterpolatedColors = 2;
+// the samples of one pass over a tile, every step-th pixel of every step-th
+// row, and the value each one came to
+struct TileSamples
+{
+  enum State : uint8_t
+  {
+    Missing,
+    Kept, // exact already, from a coarser pass or from before the render
+    Queued, // to be iterated
+    Calculated,
+    Filled // by subdivide without iterating
+  };
 
-  static bool showPalette = true;
-  ImGui::Checkbox("Show Palette", &showPalette);
+  TileSamples(FractalInfo& info, const RenderPass& renderPass, Int2 corner,
+              Int2 end)
+    : f(info), pass(renderPass), topLeft(corner)
+  {
+    uint32_t step = pass.step;
+    width = (end.x - topLeft.x + step - 1) / step;
+    height = (end.y - topLeft.y + step - 1) / step;
+    values.resize(width * height, std::nanf(""));
+    states.resize(width * height, Missing);
+    uint32_t previous = pass.previousStep;
+    for (uint32_t j = 0; j < height; j++)
+    {
+      for (uint32_t i = 0; i < width; i++)
+      {
+        uint32_t x = topLeft.x + i * step;
+        uint32_t y = topLeft.y + j * step;
+        if ((previous && y % previous == 0 && x % previous == 0) ||
+            isKnown(y, x))
+        {
+          values[j * width + i] = f.pIterations->get(y, x);
+          states[j * width + i] = Kept;
+        }
+      }
+    }
+  }
 
-  static std::vector<ImVec4> colors = {
-    {0.0, 0.0, 0.0, 1.0},
-    {1.0, 1.0, 1.0, 1.0},
-  };
+  // stores the value of sample (i, j) here and in f.pIterations
+  void setValue(uint32_t i, uint32_t j, float value)
+  {
+    values[j * width + i] = value;
+    f.pIterations->set(topLeft.y + j * pass.step, topLeft.x + i * pass.step,
+                       value);
+  }
 
-  if (ImGui::Button("Fractal Options"))
-    displayRuleMenu = true;
-  if (displayRuleMenu)
+  bool isKnown(uint32_t y, uint32_t x) const
   {
-    ImGuiWindowFlags flags = 0;
-    flags |= ImGuiWindowFlags_AlwaysAutoResize;
-    flags |= ImGuiWindowFlags_NoResize;
-    ImGui::Begin("Fractal Options", &displayRuleMenu, flags);
+    if (pass.pKnown)
+      return (*pass.pKnown)[(uint64_t)y * f.pIterations->getWidth() + x];
+    return f.pIterations->isExact(y, x);
+  }
 
-    ImGui::Checkbox("Debug Info", &debug);
+  FractalInfo& f;
+  const RenderPass& pass;
+  Int2 topLeft;
+  uint32_t width;
+  uint32_t height;
+  std::vector<float> values; // NaN where unknown
+  std::vector<uint8_t> states;
+};
+
+// iterates the samples at indices, j * width + i, as one span
+void calculateSamples(TileSamples& tile, const std::vector<uint32_t>& indices)
+{
+  if (indices.empty())
+    return;
+  FractalInfo& f = tile.f;
+  const RenderPass& pass = tile.pass;
+  std::vector<double> xs(indices.size());
+  std::vector<double> ys(indices.size());
+  for (size_t k = 0; k < indices.size(); k++)
+  {
+    // translate from pixel space to our virtual space
+    uint32_t x = tile.topLeft.x + indices[k] % tile.width * pass.step;
+    uint32_t y = tile.topLeft.y + indices[k] / tile.width * pass.step;
+    xs[k] =
+      f.window.xmin + ((f.window.xmax - f.window.xmin) / f.imageSize.x) * x;
+    ys[k] =
+      f.window.ymin + ((f.window.ymax - f.window.ymin) / f.imageSize.y) * y;
+  }
 
-    if (ImGui::SliderInt("Iterations", &f.maxIterations, 0, 2000))
+  std::vector<double> results(indices.size());
+  uint64_t iterated = 0;
+  uint64_t resolvedEarly = 0;
+  fractal::SpanArgs args{};
+  args.x = xs.data();
+  args.count = (uint32_t)xs.size();
+  args.type = f.type;
+  args.seedX = f.seedX;
+  args.seedY = f.seedY;
+  args.smooth = f.smooth;
+  args.maxIterations = f.maxIterations;
+  args.reference = f.deepZoom.enabled ? f.deepZoom.pReference : nullptr;
+  args.iterated = &iterated;
+  args.interiorChecks = f.interiorChecks;
+  args.pixelSize = (f.window.xmax - f.window.xmin) / f.imageSize.x;
+  args.resolvedEarly = &resolvedEarly;
+  args.ys = ys.data();
+  if (f.deepZoom.enabled && !args.reference)
+    calculateDeepSpan(f, args, results.data());
+  else
+    fractal::calculateSpan(args, results.data(), f.simdLevel);
+  if (pass.pCounters)
+  {
+    RenderCounters& counters = *pass.pCounters;
+    counters.points += indices.size();
+    counters.resolvedEarly += resolvedEarly;
+    if (args.reference)
     {
-      f.pGrid->clear();
-      updateView = true;
+      counters.perturbedPoints += indices.size();
+      counters.perturbedIterations += iterated;
     }
+  }
 
-    if (ImGui::Combo("Smoothing Algorithm", &smoothIdx, smoothList,
-                     IM_ARRAYSIZE(smoothList)))
-    {
-      f.smooth = (Smooth)smoothIdx;
-      updateView = true;
-      f.pGrid->clear();
-    }
+  for (size_t k = 0; k < indices.size(); k++)
+  {
+    uint32_t index = indices[k];
+    tile.setValue(index % tile.width, index / tile.width, results[k]);
+    tile.states[index] = TileSamples::Calculated;
+  }
+}
 
-    static int fractalIdx = 0;
-    static char* fractalTypes[2] = {"Mandelbrot", "Julia"};
-    if (ImGui::Combo("Fractal Type", &fractalIdx, fractalTypes, IM_ARRAYSIZE(fractalTypes)))
-    {
-      f.type = (FractalType)fractalIdx;
-      updateView = true;
-      f.pGrid->clear();
-    }
+// Mariani-Silver subdivision. The set and the bands of equal iterations
+// around it have no holes, so a rectangle whose border all came to the same
+// value is that value inside too and is filled without iterating. Otherwise
+// it's split in two along its longer side, the halves sharing the middle row
+// or column. Smooth values are rarely equal outside the set, so those only
+// fill the inside of it. The rectangles are worked through a level at a time
+// so the borders of a level go to the kernel as one span. Returns false if
+// the pass was cancelled
+bool subdivide(TileSamples& tile)
+{
+  struct Rect
+  {
+    uint32_t left;
+    uint32_t top;
+    uint32_t right;
+    uint32_t bottom;
+  };
 
-    if (f.smooth == Smooth::Distance)
+  FractalInfo& f = tile.f;
+  uint32_t width = tile.width;
+  // in distance mode everything far enough from the set is left empty, so
+  // counts as one value. NaN, a sample with no value, never equals anything
+  auto getKey = [&](uint32_t i, uint32_t j) {
+    float value = tile.values[j * width + i];
+    if (f.smooth == Smooth::Distance && value != -1.0f &&
+        value >= f.minDistance)
+      return std::numeric_limits<float>::infinity();
+    return value;
+  };
+  // small enough that the border is most of it, so it's all iterated
+  auto isSmall = [](const Rect& r) {
+    return (r.right - r.left + 1) * (r.bottom - r.top + 1) <= 16;
+  };
+
+  std::vector<Rect> rects{Rect{0, 0, width - 1, tile.height - 1}};
+  std::vector<Rect> next;
+  std::vector<uint32_t> indices;
+  while (!rects.empty())
+  {
+    if (tile.pass.isCancelled && tile.pass.isCancelled())
+      return false;
+
+    // neighbours share their edges, Queued keeps those from going in twice
+    indices.clear();
+    for (const Rect& r : rects)
     {
-      if (ImGui::SliderFloat("Distance", &f.minDistance, 0.0000000001f, 0.1f,
-                             "%.12f", ImGuiSliderFlags_Logarithmic))
-      {
-        updateView = true;
-        f.pGrid->clear();
-      }
-      if (ImGui::ColorEdit4("Distance Color", (float*)&f.distanceColor),
-          ImGuiColorEditFlags_NoInputs)
+      bool small = isSmall(r);
+      for (uint32_t j = r.top; j <= r.bottom; j++)
       {
-        updateView = true;
-        f.pGrid->clear();
+        for (uint32_t i = r.left; i <= r.right; i++)
+        {
+          bool border =
+            i == r.left || i == r.right || j == r.top || j == r.bottom;
+          uint8_t& state = tile.states[j * width + i];
+          if ((small || border) && state == TileSamples::Missing)
+          {
+            state = TileSamples::Queued;
+            indices.push_back(j * width + i);
+          }
+        }
       }
     }
+    calculateSamples(tile, indices);
 
-    if (ImGui::ColorEdit4("Inside Color", (float*)&(f.setColor),
-                          ImGuiColorEditFlags_NoInputs))
+    next.clear();
+    for (const Rect& r : rects)
     {
-      updateView = true;
-      f.pGrid->clear();
-    }
+      if (isSmall(r) || r.right - r.left < 2 || r.bottom - r.top < 2)
+        continue;
 
-    if (smooth == Smooth::Distance)
-    {
-      if (ImGui::SliderFloat("Distance", &f.minDistance, 0.0f, 0.1f, "%.12f",
-                             ImGuiSliderFlags_Logarithmic))
-      {
-        f.pGrid->clear();
-        updateView = true;
-      }
+      float first = getKey(r.left, r.top);
+      bool uniform = true;
+      for (uint32_t i = r.left; i <= r.right && uniform; i++)
+        uniform = getKey(i, r.top) == first && getKey(i, r.bottom) == first;
+      for (uint32_t j = r.top; j <= r.bottom && uniform; j++)
+        uniform = getKey(r.left, j) == first && getKey(r.right, j) == first;
 
-      if (ImGui::ColorEdit4("Distance Color", (float*)&f.distanceColor,
-                            ImGuiColorEditFlags_NoInputs))
-      {
-        f.pGrid->clear();
-        updateView = true;
-      }
-    }
-    else // smooth != Smooth::Distance
-    {
-      if (ImGui::Button("Add Color"))
-      {
-        colors.push_back(ImVec4{1.0f, 1.0f, 1.0f, 1.0f});
-        numPaletteColors++;
-        f.palette->updateColors(colors);
-        updateView = true;
-        f.pGrid->clear();
-      }
-      ImGui::SameLine();
-      if (ImGui::Button("Remove Color"))
+      if (uniform)
       {
-        if (colors.size() > 1)
+        float value = tile.values[r.top * width + r.left];
+        uint64_t filled = 0;
+        for (uint32_t j = r.top + 1; j < r.bottom; j++)
         {
-          colors.pop_back();
-          numPaletteColors--;
+          for (uint32_t i = r.left + 1; i < r.right; i++)
+          {
+            if (tile.states[j * width + i] != TileSamples::Missing)
+              continue;
+            tile.setValue(i, j, value);
+            tile.states[j * width + i] = TileSamples::Filled;
+            filled++;
+          }
         }
-        f.palette->updateColors(colors);
-        updateView = true;
-        f.pGrid->clear();
+        if (tile.pass.pCounters)
+          tile.pass.pCounters->filled += filled;
       }
-
-      for (int i = 0; i < numPaletteColors; i++)
+      else if (r.right - r.left >= r.bottom - r.top)
       {
-        if (ImGui::ColorEdit4(
-              std::string("color " + std::to_string(i + 1)).c_str(),
-              (float*)&(colors[i]), ImGuiColorEditFlags_NoInputs))
-        {
-          f.palette->updateColors(colors);
-          updateView = true;
-          f.pGrid->clear();
-        }
+        uint32_t middle = (r.left + r.right) / 2;
+        next.push_back(Rect{r.left, r.top, middle, r.bottom});
+        next.push_back(Rect{middle, r.top, r.right, r.bottom});
       }
-    }
-    if (ImGui::SliderInt("Palette Steps", &numSteps, 10, 2000, "%d",
-                         ImGuiSliderFlags_Logarithmic))
-    {
-      // we need to make sure the number of colors
-      // divides the number of steps
-      numSteps -= (numSteps % numPaletteColors);
-      f.palette->updateSize(numSteps);
-      updateView = true;
-      f.pGrid->clear();
-    }
-
-    if (f.type == FractalType::Julia)
-    {
-      if (ImGui::DragFloat("Seed X", &f.seedX, 0.0005f, -2.0f, 2.0f) ||
-          ImGui::DragFloat("Seed Y", &f.seedY, 0.0005f, -2.0f, 2.0f))
+      else
       {
-        updateView = true;
-        f.pGrid->clear();
+        uint32_t middle = (r.top + r.bottom) / 2;
+        next.push_back(Rect{r.left, r.top, r.right, middle});
+        next.push_back(Rect{r.left, middle, r.right, r.bottom});
       }
     }
-    ImGui::End();
-  }
-
-  if (updateView)
-  {
-    updateGrid(f);
+    std::swap(rects, next);
   }
-  updateView = false;
-
-  ImGui::Image((void*)(*f.pView), ImVec2(f.imageSize.x, f.imageSize.y));
-
-  auto mousePositionAbsolute = ImGui::GetMousePos();
-  auto screenPositionAbsolute = ImGui::GetItemRectMin();
-
-  bool hovering = ImGui::IsItemHovered();
-  bool mouseDragging = ImGui::IsMouseDragging(ImGuiMouseButton_Left);
-
-  mouseX = mousePositionAbsolute.x - screenPositionAbsolute.x;
-  mouseY = mousePositionAbsolute.y - screenPositionAbsolute.y;
-
-  double complexX =
-    (mouseX * ((f.window.xmax - f.window.xmin) / f.imageSize.x)) +
-    f.window.xmin;
-  double complexY =
-    -((mouseY * ((f.window.ymax - f.window.ymin) / f.imageSize.y)) +
-      f.window.ymin);
-  // negative because the top left corner is (0,0), not the bottom left corner
+  return true;
+}
+} // namespace
 
-  static bool wasDragging = false;
+namespace fractal
+{
+Palette updatePalette(std::vector<Color> colorList, const uint32_t numColors)
+{
+  auto p = Palette(colorList, numColors);
+  return p;
+}
 
-  if (hovering && mouseDragging)
+void colorize(FractalInfo& f, Int2 topLeft, Int2 bottomRight)
+{
+  automata::ProfileZone zone("fractal::colorize");
+  const Color empty{0, 0, 0, 0};
+  Color setColor = imvec4ToColor(f.setColor);
+  Color distanceColor = imvec4ToColor(f.distanceColor);
+  uint64_t width = f.pIterations->getWidth();
+  uint32_t count = bottomRight.x - topLeft.x;
+  // palette indices of a row, NaN where the palette isn't used
+  std::vector<float> indices(count);
+  for (uint32_t y = topLeft.y; y < bottomRight.y; y++)
   {
-    auto dragDelta = ImGui::GetMouseDragDelta();
-    ImGui::ResetMouseDragDelta();
-    if (dragDelta.x != 0 || dragDelta.y != 0)
+    uint64_t offset = y * width + topLeft.x;
+    const float* values = f.pIterations->getData() + offset;
+    Color* colors = (Color*)f.pGrid->getData() + offset;
+    for (uint32_t i = 0; i < count; i++)
     {
-      auto complexDiffX =
-        dragDelta.x * ((f.window.xmax - f.window.xmin) / f.imageSize.x);
-      auto complexDiffY =
-        dragDelta.y * ((f.window.ymax - f.window.ymin) / f.imageSize.y);
-
-      f.window.xmin -= complexDiffX;
-      f.window.xmax -= complexDiffX;
-      f.window.ymin -= complexDiffY;
-      f.window.ymax -= complexDiffY;
-
-      updateView = true;
-      wasDragging = true;
-      grid.translate(dragDelta.x, dragDelta.y);
+      float value = values[i];
+      indices[i] = std::nanf("");
+      if (std::isnan(value))
+        continue;
+      if (value == -1.0f)
+        colors[i] = setColor;
+      // left empty when far enough from the set
+      else if (f.smooth == Smooth::Distance)
+        colors[i] = value < f.minDistance ? distanceColor : empty;
+      else
+      {
+        colors[i] = empty;
+        indices[i] = normalizeIteration(value);
+      }
     }
+    // simdLevel only picks the kernel, so comparing kernels doesn't change
+    // how the palette is applied
+    if (f.smooth != Smooth::Distance)
+      f.palette->colorize(indices.data(), colors, count,
+                          automata::getSimdLevel());
   }
-  // zoom in
-  if (hovering && ImGui::IsMouseReleased(ImGuiMouseButton_Left) && !wasDragging)
-  {
-    f.window.xmin = (f.window.xmin + complexX) / 2;
-    f.window.xmax = (f.window.xmax + complexX) / 2;
-
-    f.window.ymin = (f.window.ymin - complexY) / 2;
-    f.window.ymax = (f.window.ymax - complexY) / 2;
-    f.pGrid->clear();
-    updateView = true;
-  }
-  // zoom out
-  if (hovering && ImGui::IsMouseClicked(ImGuiMouseButton_Right))
-  {
-    f.window.xmin -= (complexX - f.window.xmin);
-    f.window.xmax += (f.window.xmax - complexX);
-
-    f.window.ymin += (complexY + f.window.ymin);
-    f.window.ymax += (f.window.ymax + complexY);
-    f.pGrid->clear();
-    updateView = true;
-  }
-
-  if (ImGui::IsMouseReleased(ImGuiMouseButton_Left && wasDragging))
-  {
-    wasDragging = false;
-  }
-
-  if (hovering && debug)
-  {
-    ImGui::Text("Screen space: x:%d, y:%d", mouseX, mouseY);
-    ImGui::Text("Complex space: x:%f, y:%f", complexX, complexY);
-    ImGui::Text("Seed: (%f, %f)", f.seedX, f.seedY);
-    ImGui::Text("Value from function: %f",
-                (f.type == FractalType::Mandelbrot
-                   ? mandelbrot::calculatePixel(complexX, complexY, f.smooth,
-                                                f.maxIterations)
-                   : julia::calculatePixel(complexX, complexY, f.smooth,
-                                           f.maxIterations, f.seedX, f.seedY)));
-  }
-  ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
-              1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-}
-
-// should be called once per frame
-void loadGrid(FractalInfo& f)
-{
-  if (*f.pTexture)
-    (*f.pTexture)->Release();
-  if (*f.pView)
-    (*f.pView)->Release();
-
-  automata::LoadTextureFromData(f.pGrid->getData(), f.pView, f.pTexture,
-                                f.pDevice, f.imageSize.x, f.imageSize.y);
 }
 
-void updateGrid(FractalInfo& f)
+void getFractalPixels(FractalInfo& f, Int2 topLeft, Int2 bottomRight,
+                      const RenderPass& pass)
 {
-  std::vector<std::future<bool>> futures;
-  for (uint32_t i = 0; i < f.numThreads; i++)
+  TileSamples tile(f, pass, topLeft, bottomRight);
+  // a filled sample of a coarse pass would be kept by the finer ones, and a
+  // guess from samples that far apart could hide a whole filament
+  if (f.subdivide && pass.step == 1)
   {
-    futures.push_back(std::async(std::launch::async, &getFractalPixels, i, f));
+    if (!subdivide(tile))
+      return;
   }
-  for (auto&& future : futures)
+  else
   {
-    auto result = future.get();
-    if (!result)
-      throw std::runtime_error("fractal generation failed");
+    // the samples of a row go to the kernel as one span
+    std::vector<uint32_t> indices;
+    for (uint32_t j = 0; j < tile.height; j++)
+    {
+      if (pass.isCancelled && pass.isCancelled())
+        return;
+      indices.clear();
+      for (uint32_t i = 0; i < tile.width; i++)
+        if (tile.states[j * tile.width + i] == TileSamples::Missing)
+          indices.push_back(j * tile.width + i);
+      calculateSamples(tile, indices);
+    }
   }
-  loadGrid(f);
-}
 
-bool getFractalPixels(uint32_t offset, FractalInfo& f)
-{
-  for (uint32_t x = 0; x < f.imageSize.x; x++)
+  // the rest of each block shows its sample until a finer pass, as an
+  // estimate so a render that starts over still renders it
+  uint32_t step = pass.step;
+  if (step == 1)
+    return;
+  for (uint32_t j = 0; j < tile.height; j++)
   {
-    for (uint32_t y = offset; y < f.imageSize.y; y += f.numThreads)
+    for (uint32_t i = 0; i < tile.width; i++)
     {
-      if (!f.pGrid->checkCell(y, x)) // only update pixels that are empty
-      {
-        // translate from pixel space to our virtual space
-        double v_x =
-          f.window.xmin + ((f.window.xmax - f.window.xmin) / f.imageSize.x) * x;
-        double v_y =
-          f.window.ymin + ((f.window.ymax - f.window.ymin) / f.imageSize.y) * y;
-
-        double result = 0;
-        if (f.type == FractalType::Mandelbrot)
-          result =
-            mandelbrot::calculatePixel(v_x, v_y, f.smooth, f.maxIterations);
-        else if (f.type == FractalType::Julia)
-          result = julia::calculatePixel(v_x, v_y, f.smooth, f.maxIterations,
-                                         f.seedX, f.seedY);
-        if (result == -1.0)
-        {
-          f.pGrid->setCellDirectly(y, x, imvec4ToColor(f.setColor));
-        }
-        else
-        {
-          if (f.smooth == Smooth::Distance)
-          {
-            if (result < f.minDistance)
-            {
-              f.pGrid->setCellDirectly(y, x, imvec4ToColor(f.distanceColor));
-            }
-          }
-          else
-          {
-            result = normalizeIteration(result);
-            f.pGrid->setCellDirectly(y, x, f.palette->getColor(result));
-          }
-        }
-      }
+      uint8_t state = tile.states[j * tile.width + i];
+      if (state == TileSamples::Missing || state == TileSamples::Kept)
+        continue;
+      float value = tile.values[j * tile.width + i];
+      uint32_t x = topLeft.x + i * step;
+      uint32_t y = topLeft.y + j * step;
+      uint32_t blockBottom = std::min(y + step, bottomRight.y);
+      uint32_t blockRight = std::min(x + step, bottomRight.x);
+      for (uint32_t blockY = y; blockY < blockBottom; blockY++)
+        for (uint32_t blockX = x; blockX < blockRight; blockX++)
+          if (!tile.isKnown(blockY, blockX))
+            f.pIterations->setEstimate(blockY, blockX, value);
     }
   }
-  return true;
 }
 } // namespace fractal
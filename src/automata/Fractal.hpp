@@ -2,9 +2,14 @@
 #define AUTOMATA_FRACTAL
 
 #include "Grid.hpp"
+#include "IterationBuffer.hpp"
 #include "Palette.hpp"
-#include <d3d11.h>
+#include "utils/CpuFeatures.hpp"
+#include "utils/D3D11Forward.hpp"
+#include "utils/Numeric.hpp"
 
+#include <atomic>
+#include <functional>
 #include <imgui/imgui.h>
 
 enum class Smooth
@@ -35,11 +40,68 @@ struct Int2
   uint32_t y;
 };
 
+// lookups of the tile cache since it was made, for the debug panel
+struct TileCacheStats
+{
+  uint64_t hits; // from memory
+  uint64_t diskHits;
+  uint64_t misses;
+  uint64_t memoryBytes;
+  uint64_t diskBytes;
+};
+
+// how the current render is going, for the debug panel
+struct RenderStats
+{
+  uint32_t pass; // passes finished, coarsest first
+  uint32_t numPasses;
+  double firstImageMs; // until the first pass was finished
+  uint32_t tiles;
+  double wallMs;
+  double busyMs; // every tile's time added up
+  double medianTileMs;
+  double slowestTileMs;
+  uint64_t stolenTiles; // tiles a thread took from another thread's deque
+  uint32_t referenceLength; // iterations of the deep zoom reference orbit
+  double referenceMs;
+  uint32_t skippedIterations; // per point by the series, 0 for distance
+  double seriesSpeedup; // iterations with the skipped ones over without
+  double resolvedEarlyPercent; // of the points iterated, by interior checks
+  double filledPercent; // of the points, filled in without iterating
+  TileCacheStats cache;
+};
+
+namespace fractal
+{
+struct ReferenceOrbit;
+}
+
+// pixel sizes where the view switches to and from deep zoom. Doubles run out
+// of bits for the center somewhere below 1e-15, the gap stops it flipping
+// back and forth on every zoom. getNumberType gives DoubleDouble or wider
+// for both, so deep zooms never iterate in doubles
+const double deepZoomStart = 1e-13;
+const double deepZoomEnd = 1e-11;
+
+// past what doubles can place, the view is a center kept in fixed point
+// plus a window of small offsets around it. Mandelbrot views go through
+// perturbation, the renderer works out the reference orbit of the center and
+// points pReference at it. Otherwise every point is iterated in numberType
+struct DeepZoom
+{
+  bool enabled;
+  automata::BigFixed centerX;
+  automata::BigFixed centerY;
+  const fractal::ReferenceOrbit* pReference;
+  bool seriesApproximation; // lets every point skip the first iterations
+  bool perturbation;
+  automata::NumberType numberType; // the cheapest that resolves a pixel
+};
+
 struct FractalInfo
 {
   Grid* pGrid;
   Smooth smooth;
-  uint32_t numThreads;
   Palette* palette;
   float minDistance;
   int maxIterations;
@@ -53,6 +115,37 @@ struct FractalInfo
   FractalBounds window;
   float seedX;
   float seedY;
+  automata::SimdLevel simdLevel; // of the iteration kernel
+  RenderStats stats;
+  DeepZoom deepZoom; // window is relative to its center when enabled
+  bool interiorChecks; // stop orbits early once they can't escape
+  // fill rectangles with a border all one value without iterating inside
+  bool subdivide;
+  IterationBuffer* pIterations; // what the colors of pGrid are worked out from
+};
+
+// what the points of a render came to, added up across threads
+struct RenderCounters
+{
+  std::atomic<uint64_t> points; // iterated, the known ones don't count
+  std::atomic<uint64_t> resolvedEarly; // by the interior checks
+  std::atomic<uint64_t> filled; // by rectangle subdivision, not iterated
+  // points iterated as offsets from a reference orbit and the iterations
+  // they ran
+  std::atomic<uint64_t> perturbedPoints;
+  std::atomic<uint64_t> perturbedIterations;
+};
+
+// one coarse-to-fine pass over the image. Every step-th pixel of every
+// step-th row is iterated and fills the step x step block it is the top left
+// corner of
+struct RenderPass
+{
+  uint32_t step;
+  uint32_t previousStep; // its samples are exact already, 0 on the first pass
+  const std::vector<uint8_t>* pKnown; // pixels to keep, null keeps exact
+  std::function<bool()> isCancelled; // checked every row, may be empty
+  RenderCounters* pCounters; // may be null
 };
 
 namespace fractal
@@ -61,11 +154,21 @@ namespace fractal
 
   void loadGrid(FractalInfo& f);
 
+  // starts rendering the unknown pixels of f.pIterations in the background
+  // and drops the render that was running
   void updateGrid(FractalInfo& f);
 
   Palette updatePalette(std::vector<Color> colorList, const uint32_t numColors);
 
-  bool getFractalPixels(uint32_t offset, FractalInfo& f);
+  // one pass over the pixels in [topLeft, bottomRight) of f.pIterations.
+  // The corner has to be a multiple of the pass step
+  void getFractalPixels(FractalInfo& f, Int2 topLeft, Int2 bottomRight,
+                        const RenderPass& pass);
+
+  // the colors of f.pIterations in [topLeft, bottomRight) into f.pGrid, with
+  // the palette and colors of f. Unknown pixels keep their color, so what was
+  // there shows until they are rendered
+  void colorize(FractalInfo& f, Int2 topLeft, Int2 bottomRight);
 };
 
 #endif
@@ -0,0 +1,190 @@
+#include "FractalKernel.hpp"
+#include "Perturbation.hpp"
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// points in the main cardioid or the period 2 bulb never escape
+bool isInsideBulbs(double x_0, double y_0)
+{
+  double p = sqrt((x_0 - 0.25) * (x_0 - 0.25) + y_0 * y_0);
+  if (x_0 <= p - (2 * p * p) + 0.25)
+    return true;
+  return (x_0 + 1) * (x_0 + 1) + y_0 * y_0 <= 1.0 / 16;
+}
+} // namespace
+
+namespace fractal
+{
+void calculateSpan(const SpanArgs& args, double* out,
+                   automata::SimdLevel level)
+{
+  // the bulb checks take mandelbrot points out of the span, the rest are
+  // packed together so no lane is spent on them. Offsets from a reference
+  // orbit are too close together to be worth it
+  std::vector<double> xs;
+  std::vector<double> ys;
+  std::vector<uint32_t> indices;
+  SpanArgs packed = args;
+  if (args.type == FractalType::Mandelbrot && !args.reference)
+  {
+    xs.reserve(args.count);
+    indices.reserve(args.count);
+    for (uint32_t i = 0; i < args.count; i++)
+    {
+      if (isInsideBulbs(args.x[i], getPointY(args, i)))
+      {
+        out[i] = -1;
+        continue;
+      }
+      xs.push_back(args.x[i]);
+      if (args.ys)
+        ys.push_back(args.ys[i]);
+      indices.push_back(i);
+    }
+    packed.x = xs.data();
+    packed.ys = args.ys ? ys.data() : nullptr;
+    packed.count = xs.size();
+  }
+
+  std::vector<Escape> escapes(packed.count);
+  if (packed.reference)
+    iteratePerturbed(packed, escapes.data());
+#ifdef AUTOMATA_X86
+  else if (level >= automata::SimdLevel::Avx512)
+    iterateAvx512(packed, escapes.data());
+  else if (level >= automata::SimdLevel::Avx2)
+    iterateAvx2(packed, escapes.data());
+#endif
+  else
+    iterateScalar(packed, 0, escapes.data());
+
+  uint64_t resolvedEarly = 0;
+  for (uint32_t i = 0; i < packed.count; i++)
+  {
+    uint32_t index = indices.empty() ? i : indices[i];
+    out[index] =
+      getEscapeValue(escapes[i], args.smooth, args.maxIterations);
+    resolvedEarly += escapes[i].early;
+  }
+  if (args.resolvedEarly)
+    *args.resolvedEarly += resolvedEarly;
+}
+
+double getEscapeValue(const Escape& escape, Smooth smooth,
+                      uint32_t maxIterations)
+{
+  uint32_t iteration = escape.iteration;
+  double x_2 = escape.x_2;
+  double y_2 = escape.y_2;
+  if (iteration == maxIterations)
+  {
+    return -1; // inside the set
+  }
+  if (smooth == Smooth::Linear)
+  {
+    double ratio =
+      (sqrt(x_2 + y_2) - 2) / (2 - sqrt(escape.before_x * escape.before_x +
+                                        escape.before_y * escape.before_y));
+    double gradient = 1 / (ratio + 1);
+    return iteration + gradient;
+  }
+  if (smooth == Smooth::Logarithmic)
+  {
+    double log_zn = log(sqrt(x_2 + y_2));
+    double gradient = 1 - log(log_zn / log(2)) / log(2);
+    return iteration + gradient;
+  }
+  if (smooth == Smooth::Distance)
+  {
+    double mod_z = x_2 + y_2;
+    return mod_z * log(mod_z) /
+           sqrt(escape.dz_x * escape.dz_x + escape.dz_y + escape.dz_y);
+  }
+  return iteration;
+}
+
+void iterateScalar(const SpanArgs& args, uint32_t start, Escape* out)
+{
+  bool julia = args.type == FractalType::Julia;
+  double bailout = args.smooth == Smooth::Logarithmic ? 16 : 4;
+  double attracted = getAttractedDerivative(args.pixelSize);
+  for (uint32_t i = start; i < args.count; i++)
+  {
+    double c_x = julia ? args.seedX : args.x[i];
+    double c_y = julia ? args.seedY : getPointY(args, i);
+
+    double z_x = julia ? args.x[i] : 0;
+    double z_y = julia ? getPointY(args, i) : 0;
+
+    double before_x = 0;
+    double before_y = 0;
+
+    double x_2 = z_x * z_x;
+    double y_2 = z_y * z_y;
+
+    double dz_x = 1;
+    double dz_y = 0;
+
+    double saved_x = z_x;
+    double saved_y = z_y;
+    double saved_dzz_2 = 1;
+    uint32_t nextCheck = 1;
+    double dzz_2 = 1;
+    bool early = false;
+
+    uint32_t iteration = 0;
+
+    while (x_2 + y_2 < bailout && iteration < args.maxIterations)
+    {
+      before_x = z_x;
+      before_y = z_y;
+
+      // iterate: z = z^2 + c
+      z_y = 2 * z_x * z_y + c_y;
+      z_x = x_2 - y_2 + c_x;
+      x_2 = z_x * z_x;
+      y_2 = z_y * z_y;
+
+      if (args.smooth == Smooth::Distance)
+      {
+        double dz_x_new = 2 * (z_x * dz_x - z_y * dz_y);
+        double dz_y_new = 2 * (z_y * dz_x + z_x * dz_y);
+        // d/dc of z^2 + c, the julia seed is a constant
+        if (!julia)
+          dz_x_new += 1;
+
+        dz_x = dz_x_new;
+        dz_y = dz_y_new;
+      }
+
+      iteration++;
+
+      if (args.interiorChecks)
+      {
+        dzz_2 *= 4 * (x_2 + y_2);
+        if ((std::abs(z_x - saved_x) < periodEpsilon &&
+             std::abs(z_y - saved_y) < periodEpsilon &&
+             dzz_2 < saved_dzz_2) ||
+            dzz_2 < attracted * attracted)
+        {
+          early = true;
+          iteration = args.maxIterations;
+          break;
+        }
+        if (iteration == nextCheck)
+        {
+          saved_x = z_x;
+          saved_y = z_y;
+          saved_dzz_2 = dzz_2;
+          nextCheck *= 2;
+        }
+      }
+    }
+    out[i] =
+      Escape{iteration, x_2, y_2, before_x, before_y, dz_x, dz_y, early};
+  }
+}
+} // namespace fractal
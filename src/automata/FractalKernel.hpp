@@ -0,0 +1,170 @@
+#ifndef AUTOMATA_FRACTAL_KERNEL
+#define AUTOMATA_FRACTAL_KERNEL
+
+#include "Fractal.hpp"
+#include "utils/CpuFeatures.hpp"
+#include "utils/Numeric.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace fractal
+{
+struct ReferenceOrbit;
+
+// the points of one row. Mandelbrot orbits start at 0 with the point as c,
+// julia orbits start at the point with the seed as c. Value initialize it and
+// set the members that are needed, the rest are off
+struct SpanArgs
+{
+  const double* x;
+  double y;
+  uint32_t count;
+  FractalType type;
+  double seedX;
+  double seedY;
+  Smooth smooth;
+  uint32_t maxIterations;
+  // when set, the points are mandelbrot offsets from its orbit
+  const ReferenceOrbit* reference;
+  // when set, the iterations run for offsets are added to it. Iterations
+  // the series approximation skipped don't count
+  uint64_t* iterated;
+  // look for orbits caught by an attracting cycle, see periodEpsilon
+  bool interiorChecks;
+  double pixelSize; // between the points, 0 if unknown
+  uint64_t* resolvedEarly; // when set, points the checks caught are added
+  // when set, every point has a y of its own and y isn't used, for points
+  // that aren't on one row
+  const double* ys;
+};
+
+inline double getPointY(const SpanArgs& args, uint32_t i)
+{
+  return args.ys ? args.ys[i] : args.y;
+}
+
+// an orbit back within periodEpsilon of where it was at the last power of
+// two iterations, Brent style, with the derivative smaller than it was
+// there, has found an attracting cycle. A repelling one, like the cycle a
+// misiurewicz point lands on, is left to escape. An orbit whose derivative
+// in z_1 has shrunk below attractedDerivative is being pulled into one.
+// Either way it never escapes. Only the squared size of the derivative is
+// kept, the product of |2z|^2 along the orbit, which the iteration has
+// worked out already. z_0 is left out of it since mandelbrot orbits start
+// at 0
+const double periodEpsilon = 1e-13;
+const double attractedDerivative = 1e-12;
+
+// attractedDerivative for points pixelSize apart. An orbit passing close to
+// 0 shrinks the derivative by about how close it came, and near the boundary
+// at deep zooms that can be within a pixel, as next to a misiurewicz point.
+// So it has to shrink well past the pixel size too
+inline double getAttractedDerivative(double pixelSize)
+{
+  return pixelSize > 0 ? std::min(attractedDerivative, pixelSize * 1e-3)
+                       : attractedDerivative;
+}
+
+// where an orbit left the bailout circle, or where it was at maxIterations
+struct Escape
+{
+  uint32_t iteration;
+  double x_2;
+  double y_2;
+  double before_x;
+  double before_y;
+  double dz_x;
+  double dz_y;
+  bool early; // inside, found by the interior checks
+};
+
+// calculatePixel of every point in the span, the simd levels iterate several
+// points in lockstep and give the same values as the scalar one
+void calculateSpan(const SpanArgs& args, double* out,
+                   automata::SimdLevel level);
+
+// turns an orbit into the value calculatePixel returns
+double getEscapeValue(const Escape& escape, Smooth smooth,
+                      uint32_t maxIterations);
+
+void iterateScalar(const SpanArgs& args, uint32_t start, Escape* out);
+
+// iterateScalar for one point in any of the number types of utils/Numeric.
+// Only the orbit needs the precision, the derivatives stay in doubles. These
+// are deep zooms, where points just outside a minibrot follow its cycle far
+// closer than periodEpsilon, so only the derivative check is made, against
+// attracted from getAttractedDerivative
+template <typename Number>
+Escape iterateNumber(const Number& c_x, const Number& c_y, Number z_x,
+                     Number z_y, Smooth smooth, uint32_t maxIterations,
+                     bool julia, bool interiorChecks, double attracted)
+{
+  using automata::toDouble;
+  double bailout = smooth == Smooth::Logarithmic ? 16 : 4;
+
+  double before_x = 0;
+  double before_y = 0;
+
+  Number x_2 = z_x * z_x;
+  Number y_2 = z_y * z_y;
+  double x_2_rounded = toDouble(x_2);
+  double y_2_rounded = toDouble(y_2);
+
+  double dz_x = 1;
+  double dz_y = 0;
+
+  double dzz_2 = 1;
+  bool early = false;
+
+  uint32_t iteration = 0;
+
+  while (x_2_rounded + y_2_rounded < bailout && iteration < maxIterations)
+  {
+    before_x = toDouble(z_x);
+    before_y = toDouble(z_y);
+
+    // iterate: z = z^2 + c
+    Number xy = z_x * z_y;
+    z_y = xy + xy + c_y;
+    z_x = x_2 - y_2 + c_x;
+    x_2 = z_x * z_x;
+    y_2 = z_y * z_y;
+    x_2_rounded = toDouble(x_2);
+    y_2_rounded = toDouble(y_2);
+
+    if (smooth == Smooth::Distance)
+    {
+      double zx = toDouble(z_x);
+      double zy = toDouble(z_y);
+      double dz_x_new = 2 * (zx * dz_x - zy * dz_y);
+      double dz_y_new = 2 * (zy * dz_x + zx * dz_y);
+      if (!julia)
+        dz_x_new += 1;
+
+      dz_x = dz_x_new;
+      dz_y = dz_y_new;
+    }
+
+    iteration++;
+
+    if (interiorChecks)
+    {
+      dzz_2 *= 4 * (x_2_rounded + y_2_rounded);
+      if (dzz_2 < attracted * attracted)
+      {
+        early = true;
+        iteration = maxIterations;
+        break;
+      }
+    }
+  }
+  return Escape{iteration, x_2_rounded, y_2_rounded, before_x,
+                before_y,  dz_x,        dz_y,        early};
+}
+void iterateAvx2(const SpanArgs& args, Escape* out);
+void iterateAvx512(const SpanArgs& args, Escape* out);
+} // namespace fractal
+
+#endif
@@ -0,0 +1,79 @@
+#include "FractalKernel.hpp"
+
+#ifdef AUTOMATA_X86
+#include <immintrin.h>
+
+#include "FractalKernelLanes.hpp"
+
+namespace
+{
+// four doubles, compares give a vector of all ones or zeros per lane
+struct Avx2Ops
+{
+  static const int width = 4;
+  using Vec = __m256d;
+  using Mask = __m256d;
+
+  static Vec set1(double value)
+  {
+    return _mm256_set1_pd(value);
+  }
+  static Vec load(const double* from)
+  {
+    return _mm256_load_pd(from);
+  }
+  static void store(double* to, Vec value)
+  {
+    _mm256_store_pd(to, value);
+  }
+  static Vec add(Vec a, Vec b)
+  {
+    return _mm256_add_pd(a, b);
+  }
+  static Vec sub(Vec a, Vec b)
+  {
+    return _mm256_sub_pd(a, b);
+  }
+  static Vec mul(Vec a, Vec b)
+  {
+    return _mm256_mul_pd(a, b);
+  }
+  static Vec abs(Vec a)
+  {
+    return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);
+  }
+  static Mask less(Vec a, Vec b)
+  {
+    return _mm256_cmp_pd(a, b, _CMP_LT_OQ);
+  }
+  static Mask equal(Vec a, Vec b)
+  {
+    return _mm256_cmp_pd(a, b, _CMP_EQ_OQ);
+  }
+  static Mask both(Mask a, Mask b)
+  {
+    return _mm256_and_pd(a, b);
+  }
+  static Mask either(Mask a, Mask b)
+  {
+    return _mm256_or_pd(a, b);
+  }
+  static int bits(Mask mask)
+  {
+    return _mm256_movemask_pd(mask);
+  }
+  static Vec select(Mask mask, Vec a, Vec b)
+  {
+    return _mm256_blendv_pd(a, b, mask);
+  }
+};
+} // namespace
+
+namespace fractal
+{
+void iterateAvx2(const SpanArgs& args, Escape* out)
+{
+  iterateLanes<Avx2Ops>(args, out);
+}
+} // namespace fractal
+#endif
@@ -0,0 +1,79 @@
+#include "FractalKernel.hpp"
+
+#ifdef AUTOMATA_X86
+#include <immintrin.h>
+
+#include "FractalKernelLanes.hpp"
+
+namespace
+{
+// eight doubles, compares give a bit per lane in a mask register
+struct Avx512Ops
+{
+  static const int width = 8;
+  using Vec = __m512d;
+  using Mask = __mmask8;
+
+  static Vec set1(double value)
+  {
+    return _mm512_set1_pd(value);
+  }
+  static Vec load(const double* from)
+  {
+    return _mm512_load_pd(from);
+  }
+  static void store(double* to, Vec value)
+  {
+    _mm512_store_pd(to, value);
+  }
+  static Vec add(Vec a, Vec b)
+  {
+    return _mm512_add_pd(a, b);
+  }
+  static Vec sub(Vec a, Vec b)
+  {
+    return _mm512_sub_pd(a, b);
+  }
+  static Vec mul(Vec a, Vec b)
+  {
+    return _mm512_mul_pd(a, b);
+  }
+  static Vec abs(Vec a)
+  {
+    return _mm512_abs_pd(a);
+  }
+  static Mask less(Vec a, Vec b)
+  {
+    return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ);
+  }
+  static Mask equal(Vec a, Vec b)
+  {
+    return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ);
+  }
+  static Mask both(Mask a, Mask b)
+  {
+    return a & b;
+  }
+  static Mask either(Mask a, Mask b)
+  {
+    return a | b;
+  }
+  static int bits(Mask mask)
+  {
+    return mask;
+  }
+  static Vec select(Mask mask, Vec a, Vec b)
+  {
+    return _mm512_mask_mov_pd(a, mask, b);
+  }
+};
+} // namespace
+
+namespace fractal
+{
+void iterateAvx512(const SpanArgs& args, Escape* out)
+{
+  iterateLanes<Avx512Ops>(args, out);
+}
+} // namespace fractal
+#endif
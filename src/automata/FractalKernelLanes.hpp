@@ -0,0 +1,242 @@
+#ifndef AUTOMATA_FRACTAL_KERNEL_LANES
+#define AUTOMATA_FRACTAL_KERNEL_LANES
+
+#include "FractalKernel.hpp"
+
+// the lane bookkeeping the simd kernels share, included by the isa specific
+// files only. Ops wraps one instruction set's vectors:
+//   width, Vec and Mask, the vector of doubles and the result of a compare
+//   set1, load, store, add, sub, mul and abs
+//   less and equal, both ordered, give a Mask
+//   both and either combine Masks, bits has a bit per lane
+//   select(mask, a, b) is b in the lanes of mask and a in the rest
+// Everything is templated on Ops, so each isa file compiles its own copy
+// with its own flags
+namespace fractal
+{
+// the kernel state in memory, where lanes are handed their next point
+template <typename Ops>
+struct Lanes
+{
+  static const int width = Ops::width;
+
+  alignas(sizeof(typename Ops::Vec)) double z_x[width];
+  alignas(sizeof(typename Ops::Vec)) double z_y[width];
+  alignas(sizeof(typename Ops::Vec)) double c_x[width];
+  alignas(sizeof(typename Ops::Vec)) double c_y[width];
+  alignas(sizeof(typename Ops::Vec)) double before_x[width];
+  alignas(sizeof(typename Ops::Vec)) double before_y[width];
+  alignas(sizeof(typename Ops::Vec)) double x_2[width];
+  alignas(sizeof(typename Ops::Vec)) double y_2[width];
+  alignas(sizeof(typename Ops::Vec)) double dz_x[width];
+  alignas(sizeof(typename Ops::Vec)) double dz_y[width];
+  alignas(sizeof(typename Ops::Vec)) double iteration[width];
+  alignas(sizeof(typename Ops::Vec)) double saved_x[width];
+  alignas(sizeof(typename Ops::Vec)) double saved_y[width];
+  alignas(sizeof(typename Ops::Vec)) double saved_dzz_2[width];
+  alignas(sizeof(typename Ops::Vec)) double nextCheck[width];
+  alignas(sizeof(typename Ops::Vec)) double dzz_2[width];
+  uint32_t point[width];
+
+  // the same starting state as iterateScalar
+  void start(const SpanArgs& args, uint32_t index, int lane)
+  {
+    bool julia = args.type == FractalType::Julia;
+    c_x[lane] = julia ? args.seedX : args.x[index];
+    c_y[lane] = julia ? args.seedY : getPointY(args, index);
+    z_x[lane] = julia ? args.x[index] : 0;
+    z_y[lane] = julia ? getPointY(args, index) : 0;
+    before_x[lane] = 0;
+    before_y[lane] = 0;
+    x_2[lane] = z_x[lane] * z_x[lane];
+    y_2[lane] = z_y[lane] * z_y[lane];
+    dz_x[lane] = 1;
+    dz_y[lane] = 0;
+    iteration[lane] = 0;
+    saved_x[lane] = z_x[lane];
+    saved_y[lane] = z_y[lane];
+    saved_dzz_2[lane] = 1;
+    nextCheck[lane] = 1;
+    dzz_2[lane] = 1;
+    point[lane] = index;
+  }
+};
+
+// the scalar loop on Ops::width points at a time. a lane that escapes hands
+// its orbit out and starts on the next point of the span, so lanes never idle
+// until the span runs out. the operations and their order match
+// iterateScalar, interior checks included, so the results are bit for bit
+// the same. The checks are a template argument so that the loop without
+// them keeps its registers to itself
+template <typename Ops, bool interiorChecks>
+void iterateLanes(const SpanArgs& args, Escape* out)
+{
+  using Vec = typename Ops::Vec;
+  using Mask = typename Ops::Mask;
+  const int width = Ops::width;
+  const bool julia = args.type == FractalType::Julia;
+  const bool distance = args.smooth == Smooth::Distance;
+  const Vec bailout = Ops::set1(args.smooth == Smooth::Logarithmic ? 16 : 4);
+  const Vec maxIterations = Ops::set1(args.maxIterations);
+  const Vec one = Ops::set1(1);
+  const Vec two = Ops::set1(2);
+  const Vec four = Ops::set1(4);
+  // a lane caught by the interior checks jumps past maxIterations, so it
+  // finishes like any other and can be told apart when it's handed out
+  const Vec caughtIteration = Ops::set1(args.maxIterations + 1.0);
+  const Vec epsilon = Ops::set1(periodEpsilon);
+  const double attractedDerivative = getAttractedDerivative(args.pixelSize);
+  const Vec attracted = Ops::set1(attractedDerivative * attractedDerivative);
+
+  Lanes<Ops> lanes;
+  uint32_t nextPoint = 0;
+  int occupied = 0;
+  for (int lane = 0; lane < width; lane++)
+  {
+    if (nextPoint < args.count)
+    {
+      lanes.start(args, nextPoint++, lane);
+      occupied |= 1 << lane;
+    }
+    else
+    {
+      // never active again
+      lanes.iteration[lane] = args.maxIterations;
+    }
+  }
+
+  Vec z_x, z_y, c_x, c_y, before_x, before_y, x_2, y_2, dz_x, dz_y, iteration,
+    saved_x, saved_y, saved_dzz_2, nextCheck, dzz_2;
+  auto load = [&] {
+    z_x = Ops::load(lanes.z_x);
+    z_y = Ops::load(lanes.z_y);
+    c_x = Ops::load(lanes.c_x);
+    c_y = Ops::load(lanes.c_y);
+    before_x = Ops::load(lanes.before_x);
+    before_y = Ops::load(lanes.before_y);
+    x_2 = Ops::load(lanes.x_2);
+    y_2 = Ops::load(lanes.y_2);
+    dz_x = Ops::load(lanes.dz_x);
+    dz_y = Ops::load(lanes.dz_y);
+    iteration = Ops::load(lanes.iteration);
+    saved_x = Ops::load(lanes.saved_x);
+    saved_y = Ops::load(lanes.saved_y);
+    saved_dzz_2 = Ops::load(lanes.saved_dzz_2);
+    nextCheck = Ops::load(lanes.nextCheck);
+    dzz_2 = Ops::load(lanes.dzz_2);
+  };
+  auto store = [&] {
+    Ops::store(lanes.z_x, z_x);
+    Ops::store(lanes.z_y, z_y);
+    Ops::store(lanes.c_x, c_x);
+    Ops::store(lanes.c_y, c_y);
+    Ops::store(lanes.before_x, before_x);
+    Ops::store(lanes.before_y, before_y);
+    Ops::store(lanes.x_2, x_2);
+    Ops::store(lanes.y_2, y_2);
+    Ops::store(lanes.dz_x, dz_x);
+    Ops::store(lanes.dz_y, dz_y);
+    Ops::store(lanes.iteration, iteration);
+    Ops::store(lanes.saved_x, saved_x);
+    Ops::store(lanes.saved_y, saved_y);
+    Ops::store(lanes.saved_dzz_2, saved_dzz_2);
+    Ops::store(lanes.nextCheck, nextCheck);
+    Ops::store(lanes.dzz_2, dzz_2);
+  };
+  load();
+
+  while (occupied)
+  {
+    Mask active = Ops::both(Ops::less(Ops::add(x_2, y_2), bailout),
+                            Ops::less(iteration, maxIterations));
+    int finished = ~Ops::bits(active) & occupied;
+    if (finished)
+    {
+      store();
+      for (int lane = 0; lane < width; lane++)
+      {
+        if (!(finished & (1 << lane)))
+          continue;
+        bool early = lanes.iteration[lane] > args.maxIterations;
+        uint32_t iterations =
+          early ? args.maxIterations : (uint32_t)lanes.iteration[lane];
+        out[lanes.point[lane]] =
+          Escape{iterations,           lanes.x_2[lane],
+                 lanes.y_2[lane],      lanes.before_x[lane],
+                 lanes.before_y[lane], lanes.dz_x[lane],
+                 lanes.dz_y[lane],     early};
+        if (nextPoint < args.count)
+        {
+          lanes.start(args, nextPoint++, lane);
+        }
+        else
+        {
+          lanes.iteration[lane] = args.maxIterations;
+          occupied &= ~(1 << lane);
+        }
+      }
+      load();
+      continue;
+    }
+
+    // every occupied lane is active here, empty lanes compute garbage
+    before_x = z_x;
+    before_y = z_y;
+
+    // iterate: z = z^2 + c
+    z_y = Ops::add(Ops::mul(Ops::mul(two, z_x), z_y), c_y);
+    z_x = Ops::add(Ops::sub(x_2, y_2), c_x);
+    x_2 = Ops::mul(z_x, z_x);
+    y_2 = Ops::mul(z_y, z_y);
+
+    if (distance)
+    {
+      Vec dz_x_new = Ops::sub(Ops::mul(z_x, dz_x), Ops::mul(z_y, dz_y));
+      Vec dz_y_new = Ops::add(Ops::mul(z_y, dz_x), Ops::mul(z_x, dz_y));
+      dz_x = Ops::mul(two, dz_x_new);
+      dz_y = Ops::mul(two, dz_y_new);
+      if (!julia)
+        dz_x = Ops::add(dz_x, one);
+    }
+
+    iteration = Ops::add(iteration, one);
+
+    if (interiorChecks)
+    {
+      dzz_2 = Ops::mul(dzz_2, Ops::mul(four, Ops::add(x_2, y_2)));
+
+      Mask returned =
+        Ops::both(Ops::both(Ops::less(Ops::abs(Ops::sub(z_x, saved_x)),
+                                      epsilon),
+                            Ops::less(Ops::abs(Ops::sub(z_y, saved_y)),
+                                      epsilon)),
+                  Ops::less(dzz_2, saved_dzz_2));
+      Mask shrunk = Ops::less(dzz_2, attracted);
+      // both are rare, so they're branched around
+      Mask caught = Ops::either(returned, shrunk);
+      if (Ops::bits(caught))
+        iteration = Ops::select(caught, iteration, caughtIteration);
+
+      Mask save = Ops::equal(iteration, nextCheck);
+      if (Ops::bits(save))
+      {
+        saved_x = Ops::select(save, saved_x, z_x);
+        saved_y = Ops::select(save, saved_y, z_y);
+        saved_dzz_2 = Ops::select(save, saved_dzz_2, dzz_2);
+        nextCheck = Ops::select(save, nextCheck, Ops::mul(two, nextCheck));
+      }
+    }
+  }
+}
+
+template <typename Ops>
+void iterateLanes(const SpanArgs& args, Escape* out)
+{
+  if (args.interiorChecks)
+    iterateLanes<Ops, true>(args, out);
+  else
+    iterateLanes<Ops, false>(args, out);
+}
+} // namespace fractal
+
+#endif
@@ -0,0 +1,357 @@
+#include "FractalRenderer.hpp"
+
+#include "utils/Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+// pixels per side of the blocks each pass colors from one sample
+const uint32_t passSteps[] = {4, 2, 1};
+
+// about 4000 tiles in memory, and the file is started over past 256MB
+const char* const cachePath = "fractal_tiles.cache";
+const uint64_t cacheMemoryBudget = 64ull << 20;
+const uint64_t cacheDiskBudget = 256ull << 20;
+
+double getMsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(
+           std::chrono::steady_clock::now() - start)
+    .count();
+}
+
+void copyRect(const IterationBuffer& from, IterationBuffer& to, Int2 topLeft,
+              Int2 bottomRight)
+{
+  uint64_t width = to.getWidth();
+  for (uint32_t y = topLeft.y; y < bottomRight.y; y++)
+  {
+    uint64_t offset = (uint64_t)y * width + topLeft.x;
+    std::memcpy(to.getData() + offset, from.getData() + offset,
+                (bottomRight.x - topLeft.x) * sizeof(float));
+    std::memcpy(to.getExactData() + offset, from.getExactData() + offset,
+                bottomRight.x - topLeft.x);
+  }
+}
+// the tiles of the cache a view overlaps, with the part of each that is in the
+// view. originX and originY are the view's top left pixel on the quadtree
+void forEachCacheTile(
+  int64_t originX, int64_t originY, uint32_t width, uint32_t height,
+  const std::function<void(int64_t, int64_t, Int2, Int2)>& visit)
+{
+  const int64_t size = fractal::TileCache::tileSize;
+  auto floorDiv = [size](int64_t a) {
+    return a >= 0 ? a / size : -((-a + size - 1) / size);
+  };
+  for (int64_t ty = floorDiv(originY); ty * size < originY + height; ty++)
+  {
+    for (int64_t tx = floorDiv(originX); tx * size < originX + width; tx++)
+    {
+      Int2 topLeft{(uint32_t)(std::max(tx * size, originX) - originX),
+                   (uint32_t)(std::max(ty * size, originY) - originY)};
+      Int2 bottomRight{
+        (uint32_t)(std::min((tx + 1) * size, originX + width) - originX),
+        (uint32_t)(std::min((ty + 1) * size, originY + height) - originY)};
+      visit(tx, ty, topLeft, bottomRight);
+    }
+  }
+}
+} // namespace
+
+namespace fractal
+{
+FractalRenderer::FractalRenderer()
+  : m_pool(std::max(1u, std::thread::hardware_concurrency()) - 1),
+    m_cache(cachePath, cacheMemoryBudget, cacheDiskBudget),
+    m_generation(0),
+    m_pending(0, 0),
+    m_stats{},
+    m_stop(false)
+{
+  m_thread = std::thread(&FractalRenderer::renderLoop, this);
+}
+
+FractalRenderer::~FractalRenderer()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+    m_generation++;
+  }
+  m_wake.notify_all();
+  m_thread.join();
+}
+
+void FractalRenderer::start(const FractalInfo& f)
+{
+  std::unique_ptr<Job> job(new Job{f, *f.pIterations, {}, {}, 0,
+                                   std::chrono::steady_clock::now()});
+  // the job only works out values, colors are left to publish
+  job->info.pIterations = &job->work;
+  job->info.pGrid = nullptr;
+  job->info.palette = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    job->generation = ++m_generation;
+    m_next = std::move(job);
+    if (m_pending.getWidth() != f.pIterations->getWidth() ||
+        m_pending.getHeight() != f.pIterations->getHeight())
+      m_pending =
+        IterationBuffer(f.pIterations->getWidth(), f.pIterations->getHeight());
+    m_finished.clear();
+    m_stats = RenderStats{};
+  }
+  m_wake.notify_all();
+}
+
+bool FractalRenderer::publish(FractalInfo& f)
+{
+  automata::ProfileZone zone("FractalRenderer::publish");
+  std::lock_guard<std::mutex> lock(m_mutex);
+  f.stats = m_stats;
+  IterationBuffer& values = *f.pIterations;
+  if (m_finished.empty() || values.getWidth() != m_pending.getWidth() ||
+      values.getHeight() != m_pending.getHeight())
+    return false;
+  for (const auto& rect : m_finished)
+  {
+    copyRect(m_pending, values, rect.first, rect.second);
+    colorize(f, rect.first, rect.second);
+  }
+  m_finished.clear();
+  return true;
+}
+
+void FractalRenderer::renderLoop()
+{
+  automata::profiler::setThreadName("fractal renderer");
+  while (true)
+  {
+    std::unique_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [this] { return m_stop || m_next; });
+      if (m_stop)
+        return;
+      job = std::move(m_next);
+    }
+    render(*job);
+  }
+}
+
+void FractalRenderer::render(Job& job)
+{
+  automata::ProfileZone zone("FractalRenderer::render");
+  readCache(job);
+  IterationBuffer& work = job.work;
+  uint32_t width = work.getWidth();
+  uint32_t height = work.getHeight();
+  uint32_t tilesX = (width + tileSize - 1) / tileSize;
+  uint32_t tilesY = (height + tileSize - 1) / tileSize;
+  uint64_t numKnown = 0;
+  job.known.resize((uint64_t)width * height);
+  std::vector<uint8_t> tileKnown(tilesX * tilesY, 1);
+  for (uint32_t y = 0; y < height; y++)
+  {
+    for (uint32_t x = 0; x < width; x++)
+    {
+      // estimates from a render that didn't finish are rendered again
+      bool known = work.isExact(y, x);
+      job.known[(uint64_t)y * width + x] = known;
+      numKnown += known;
+      tileKnown[(y / tileSize) * tilesX + x / tileSize] &= known;
+    }
+  }
+  // only the tiles with something left to render, after a pan the strips
+  // that came in
+  std::vector<uint32_t> tiles;
+  for (uint32_t tile = 0; tile < tileKnown.size(); tile++)
+    if (!tileKnown[tile])
+      tiles.push_back(tile);
+
+  // after a small pan most of the image is known and the new strip is
+  // quicker to render at full resolution straight away
+  std::vector<uint32_t> steps(std::begin(passSteps), std::end(passSteps));
+  if (numKnown * 2 > job.known.size())
+    steps = {1};
+
+  uint64_t generation = job.generation;
+  DeepZoom& deep = job.info.deepZoom;
+  double referenceMs = 0;
+  auto cancelled = [this, generation] { return isCancelled(generation); };
+  if (deep.enabled && deep.perturbation &&
+      job.info.type == FractalType::Mandelbrot)
+  {
+    // a deep orbit can take long enough that the next view is waiting on it
+    auto referenceStart = std::chrono::steady_clock::now();
+    job.reference = getReferenceOrbit(deep.centerX, deep.centerY,
+                                      job.info.maxIterations, cancelled);
+    if (deep.seriesApproximation)
+    {
+      const FractalBounds& w = job.info.window;
+      double radiusX = std::max(std::abs(w.xmin), std::abs(w.xmax));
+      double radiusY = std::max(std::abs(w.ymin), std::abs(w.ymax));
+      approximateSeries(job.reference, std::hypot(radiusX, radiusY),
+                        (w.xmax - w.xmin) / job.info.imageSize.x, cancelled);
+    }
+    if (isCancelled(generation))
+      return;
+    deep.pReference = &job.reference;
+    referenceMs = getMsSince(referenceStart);
+  }
+
+  std::vector<double> tileMs;
+  uint64_t stolen = m_pool.getStolenCount();
+
+  RenderCounters counters{};
+  RenderPass pass{0, 0, &job.known, cancelled, &counters};
+  for (uint32_t i = 0; i < steps.size(); i++)
+  {
+    pass.previousStep = pass.step;
+    pass.step = steps[i];
+    std::vector<double> passMs(tiles.size());
+    m_pool.parallelFor(tiles.size(), [&](uint32_t index) {
+      if (isCancelled(generation))
+        return;
+      uint32_t tile = tiles[index];
+      auto tileStart = std::chrono::steady_clock::now();
+      Int2 topLeft{(tile % tilesX) * tileSize, (tile / tilesX) * tileSize};
+      Int2 bottomRight{std::min(topLeft.x + tileSize, width),
+                       std::min(topLeft.y + tileSize, height)};
+      {
+        automata::ProfileZone tileZone("getFractalPixels");
+        getFractalPixels(job.info, topLeft, bottomRight, pass);
+      }
+      passMs[index] = getMsSince(tileStart);
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (isCancelled(generation))
+        return;
+      copyRect(work, m_pending, topLeft, bottomRight);
+      m_finished.emplace_back(topLeft, bottomRight);
+    });
+    tileMs.insert(tileMs.end(), passMs.begin(), passMs.end());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (isCancelled(generation))
+      return;
+    RenderStats& stats = m_stats;
+    stats.pass = i + 1;
+    stats.numPasses = steps.size();
+    stats.wallMs = getMsSince(job.start);
+    if (i == 0)
+      stats.firstImageMs = stats.wallMs;
+    stats.tiles = tileMs.size();
+    stats.busyMs = 0;
+    for (double ms : tileMs)
+      stats.busyMs += ms;
+    std::vector<double> sorted = tileMs;
+    if (!sorted.empty())
+    {
+      std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2,
+                       sorted.end());
+      stats.medianTileMs = sorted[sorted.size() / 2];
+      stats.slowestTileMs = *std::max_element(sorted.begin(), sorted.end());
+    }
+    stats.stolenTiles = m_pool.getStolenCount() - stolen;
+    stats.referenceLength = job.reference.x.size();
+    stats.referenceMs = referenceMs;
+    // distance estimates run every point from the start, see
+    // iteratePerturbed
+    uint32_t skipped =
+      job.info.smooth == Smooth::Distance ? 0 : job.reference.skipped;
+    stats.skippedIterations = skipped;
+    // each point would have run the skipped iterations on top
+    uint64_t iterations = counters.perturbedIterations;
+    stats.seriesSpeedup =
+      iterations
+        ? (iterations + (double)counters.perturbedPoints * skipped) / iterations
+        : 1;
+    stats.resolvedEarlyPercent =
+      counters.points ? 100.0 * counters.resolvedEarly / counters.points : 0;
+    uint64_t samples = counters.points + counters.filled;
+    stats.filledPercent = samples ? 100.0 * counters.filled / samples : 0;
+    stats.cache = m_cache.getStats();
+  }
+
+  writeCache(job);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!isCancelled(generation))
+    m_stats.cache = m_cache.getStats();
+}
+
+void FractalRenderer::readCache(Job& job)
+{
+  TileKey key;
+  int64_t originX;
+  int64_t originY;
+  if (!getTileOrigin(job.info, key, originX, originY))
+    return;
+  IterationBuffer& work = job.work;
+  const int64_t size = TileCache::tileSize;
+  std::vector<float> values(size * size);
+  std::vector<std::pair<Int2, Int2>> found;
+  forEachCacheTile(
+    originX, originY, work.getWidth(), work.getHeight(),
+    [&](int64_t tx, int64_t ty, Int2 topLeft, Int2 bottomRight) {
+      bool needed = false;
+      for (uint32_t y = topLeft.y; y < bottomRight.y && !needed; y++)
+        for (uint32_t x = topLeft.x; x < bottomRight.x && !needed; x++)
+          needed = !work.isExact(y, x);
+      key.x = tx;
+      key.y = ty;
+      if (!needed || !m_cache.find(key, values.data()))
+        return;
+      for (uint32_t y = topLeft.y; y < bottomRight.y; y++)
+      {
+        const float* row = values.data() + (originY + y - ty * size) * size +
+                           (originX - tx * size);
+        for (uint32_t x = topLeft.x; x < bottomRight.x; x++)
+          if (!work.isExact(y, x) && !std::isnan(row[x]))
+            work.set(y, x, row[x]);
+      }
+      found.emplace_back(topLeft, bottomRight);
+    });
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (isCancelled(job.generation))
+    return;
+  for (const auto& rect : found)
+  {
+    copyRect(work, m_pending, rect.first, rect.second);
+    m_finished.push_back(rect);
+  }
+}
+
+void FractalRenderer::writeCache(Job& job)
+{
+  TileKey key;
+  int64_t originX;
+  int64_t originY;
+  if (!getTileOrigin(job.info, key, originX, originY))
+    return;
+  IterationBuffer& work = job.work;
+  const int64_t size = TileCache::tileSize;
+  std::vector<float> values(size * size);
+  forEachCacheTile(
+    originX, originY, work.getWidth(), work.getHeight(),
+    [&](int64_t tx, int64_t ty, Int2 topLeft, Int2 bottomRight) {
+      std::fill(values.begin(), values.end(), std::nanf(""));
+      for (uint32_t y = topLeft.y; y < bottomRight.y; y++)
+      {
+        float* row = values.data() + (originY + y - ty * size) * size +
+                     (originX - tx * size);
+        for (uint32_t x = topLeft.x; x < bottomRight.x; x++)
+          if (work.isExact(y, x))
+            row[x] = work.get(y, x);
+      }
+      key.x = tx;
+      key.y = ty;
+      m_cache.store(key, values.data());
+    });
+}
+} // namespace fractal
@@ -0,0 +1,90 @@
+#ifndef AUTOMATA_FRACTAL_RENDERER
+#define AUTOMATA_FRACTAL_RENDERER
+
+#include "Fractal.hpp"
+#include "Perturbation.hpp"
+#include "TileCache.hpp"
+#include "utils/ThreadPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fractal
+{
+// renders fractals on a thread of its own, so a slow render never holds up a
+// frame. A render goes coarse to fine, every 4th pixel, then every 2nd, then
+// all of them, and each finished tile is handed back through publish
+class FractalRenderer
+{
+public:
+  // pixels per side of the squares a pass hands to the thread pool, small
+  // enough that a thread stuck near the set doesn't hold up the pass. A
+  // multiple of every pass step
+  static const uint32_t tileSize = 32;
+
+  FractalRenderer();
+
+  ~FractalRenderer();
+
+  // drops whatever is being rendered and starts on f. The exact values
+  // already in f.pIterations are kept and only the rest are rendered
+  void start(const FractalInfo& f);
+
+  // copies the tiles finished since the last call into f.pIterations,
+  // colors them into f.pGrid and the progress into f.stats. Returns false if
+  // nothing changed
+  bool publish(FractalInfo& f);
+
+private:
+  struct Job
+  {
+    FractalInfo info;
+    IterationBuffer work; // the job's own copy, info.pIterations points here
+    std::vector<uint8_t> known; // exact pixels from before the job started
+    ReferenceOrbit reference; // of the deep zoom center
+    uint64_t generation;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  void renderLoop();
+
+  void render(Job& job);
+
+  // fills the pixels of the job that aren't exact from cached tiles and
+  // publishes them
+  void readCache(Job& job);
+
+  // caches the exact values of the job's tiles, the parts of those at the
+  // edges of the view that it covers
+  void writeCache(Job& job);
+
+  bool isCancelled(uint64_t generation)
+  {
+    return m_generation != generation;
+  }
+
+  // its own workers, so a fractal pass doesn't keep the shared pool from
+  // stepping a simulation
+  automata::ThreadPool m_pool;
+  TileCache m_cache;
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::unique_ptr<Job> m_next; // waiting for the render thread
+  std::atomic<uint64_t> m_generation; // bumped by start, cancels older jobs
+  // the finished tiles of the current job and where they are, guarded by
+  // m_mutex like everything below
+  IterationBuffer m_pending;
+  std::vector<std::pair<Int2, Int2>> m_finished;
+  RenderStats m_stats;
+  bool m_stop;
+};
+} // namespace fractal
+
+#endif
@@ -0,0 +1,505 @@
+#include "Fractal.hpp"
+#include "FractalRenderer.hpp"
+#include "Julia.hpp"
+#include "Mandelbrot.hpp"
+#include "TileCache.hpp"
+
+#include "imgui/imgui.h"
+#include "utils/LoadTextureFromData.hpp"
+#include "utils/Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <d3d11.h>
+#include <string>
+
+namespace
+{
+// started the first time a fractal is shown and stopped at exit
+fractal::FractalRenderer& getRenderer()
+{
+  static fractal::FractalRenderer renderer;
+  return renderer;
+}
+
+// moves the middle of the window into the deep zoom center, so the window
+// stays small offsets around 0 however far in the view goes
+void recenterDeepZoom(FractalInfo& f)
+{
+  DeepZoom& deep = f.deepZoom;
+  uint32_t limbs = automata::BigFixed::getLimbsFor(
+    (f.window.xmax - f.window.xmin) / f.imageSize.x);
+  double midX = (f.window.xmin + f.window.xmax) / 2;
+  double midY = (f.window.ymin + f.window.ymax) / 2;
+  deep.centerX += automata::BigFixed(midX, limbs);
+  deep.centerY += automata::BigFixed(midY, limbs);
+  deep.centerX.setFractionLimbs(limbs);
+  deep.centerY.setFractionLimbs(limbs);
+  deep.numberType =
+    automata::getNumberType((f.window.xmax - f.window.xmin) / f.imageSize.x);
+  f.window = FractalBounds{f.window.xmin - midX, f.window.xmax - midX,
+                           f.window.ymin - midY, f.window.ymax - midY};
+}
+
+void setDeepZoom(FractalInfo& f, bool enabled)
+{
+  DeepZoom& deep = f.deepZoom;
+  if (deep.enabled == enabled)
+    return;
+  deep.enabled = enabled;
+  if (enabled)
+  {
+    deep.centerX = automata::BigFixed();
+    deep.centerY = automata::BigFixed();
+    recenterDeepZoom(f);
+    return;
+  }
+  double centerX = deep.centerX.toDouble();
+  double centerY = deep.centerY.toDouble();
+  f.window = FractalBounds{f.window.xmin + centerX, f.window.xmax + centerX,
+                           f.window.ymin + centerY, f.window.ymax + centerY};
+}
+} // namespace
+
+namespace fractal
+{
+void showAutomataWindow(ID3D11Device* pDevice)
+{
+  automata::ProfileZone zone("fractal::showAutomataWindow");
+  std::vector<Color> initialColors = {
+    Color{0, 0, 0, 255}, Color{255, 255, 255, 255}};
+  static Grid grid(1000, 500);
+  static IterationBuffer iterationBuffer(1000, 500);
+  static Smooth smooth = Smooth::Logarithmic;
+  static int numSteps = 100;
+  static int numPaletteColors = 2;
+  static Palette palette(initialColors, numSteps);
+  static float minDistance = 0.01f;
+  static int iterations = 1000;
+  static Int2 imageSize{1000, 500};
+  static ID3D11ShaderResourceView* pView = NULL;
+  static ID3D11Texture2D* pTexture = NULL;
+  static ImVec4 setColor = {0, 0, 0, 1};
+  static ImVec4 distanceColor = {1, 1, 1, 1};
+  static FractalType type = FractalType::Mandelbrot;
+  static FractalBounds window{-2.0, 2.0, -1.0, 1.0};
+  static float seedX = -1.0;
+  static float seedY = 0.0;
+
+  static FractalInfo f{&grid,       smooth,        &palette,
+                       minDistance, iterations,    imageSize,
+                       &pView,      &pTexture,     pDevice,
+                       setColor,    distanceColor, type,
+                       window,      seedX,         seedY,
+                       automata::getSimdLevel(), RenderStats{},
+                       DeepZoom{false, automata::BigFixed(),
+                                automata::BigFixed(), nullptr, true, true,
+                                automata::NumberType::Double},
+                       true,        true,          &iterationBuffer};
+
+  static bool displayRuleMenu = false;
+
+  static uint32_t mouseX;
+  static uint32_t mouseY;
+
+  static bool updateView = true;
+  // only the colors changed, the iterations can stay
+  bool recolor = false;
+  static bool debug = true;
+
+  const char* smoothList[] = {"None", "Linear", "Logarithmic",
+                              "Distance Estimate"};
+  static int smoothIdx = (int)smooth;
+  static int numInterpolatedColors = 2;
+
+  static bool showPalette = true;
+  ImGui::Checkbox("Show Palette", &showPalette);
+
+  static std::vector<ImVec4> colors = {
+    {0.0, 0.0, 0.0, 1.0},
+    {1.0, 1.0, 1.0, 1.0},
+  };
+
+  if (ImGui::Button("Fractal Options"))
+    displayRuleMenu = true;
+  if (displayRuleMenu)
+  {
+    ImGuiWindowFlags flags = 0;
+    flags |= ImGuiWindowFlags_AlwaysAutoResize;
+    flags |= ImGuiWindowFlags_NoResize;
+    ImGui::Begin("Fractal Options", &displayRuleMenu, flags);
+
+    ImGui::Checkbox("Debug Info", &debug);
+
+    // only the levels this cpu can run, sse4.1 has no kernel of its own and
+    // iterates one point at a time
+    const char* levels[4];
+    for (int i = 0; i < 4; i++)
+      levels[i] = automata::getSimdLevelName((automata::SimdLevel)i);
+    int levelIdx = (int)f.simdLevel;
+    if (ImGui::Combo("Kernel", &levelIdx, levels,
+                     (int)automata::getSimdLevel() + 1))
+    {
+      f.simdLevel = (automata::SimdLevel)levelIdx;
+      updateView = true;
+      f.pIterations->clear();
+    }
+
+    // deep zooms need far more iterations to show any detail
+    if (ImGui::SliderInt("Iterations", &f.maxIterations, 0,
+                         f.deepZoom.enabled ? 100000 : 2000, "%d",
+                         f.deepZoom.enabled ? ImGuiSliderFlags_Logarithmic
+                                            : 0))
+    {
+      f.pIterations->clear();
+      updateView = true;
+    }
+
+    if (ImGui::Combo("Smoothing Algorithm", &smoothIdx, smoothList,
+                     IM_ARRAYSIZE(smoothList)))
+    {
+      f.smooth = (Smooth)smoothIdx;
+      updateView = true;
+      f.pIterations->clear();
+    }
+
+    static int fractalIdx = 0;
+    static char* fractalTypes[2] = {"Mandelbrot", "Julia"};
+    if (ImGui::Combo("Fractal Type", &fractalIdx, fractalTypes, IM_ARRAYSIZE(fractalTypes)))
+    {
+      f.type = (FractalType)fractalIdx;
+      updateView = true;
+      f.pIterations->clear();
+    }
+
+    if (f.smooth == Smooth::Distance)
+    {
+      // a render, not a recolor, the subdivision fills by it too
+      if (ImGui::SliderFloat("Distance", &f.minDistance, 0.0000000001f, 0.1f,
+                             "%.12f", ImGuiSliderFlags_Logarithmic))
+      {
+        updateView = true;
+        f.pIterations->clear();
+      }
+      if (ImGui::ColorEdit4("Distance Color", (float*)&f.distanceColor,
+                            ImGuiColorEditFlags_NoInputs))
+      {
+        recolor = true;
+      }
+    }
+
+    if (ImGui::ColorEdit4("Inside Color", (float*)&(f.setColor),
+                          ImGuiColorEditFlags_NoInputs))
+    {
+      recolor = true;
+    }
+
+    if (f.smooth != Smooth::Distance)
+    {
+      if (ImGui::Button("Add Color"))
+      {
+        colors.push_back(ImVec4{1.0f, 1.0f, 1.0f, 1.0f});
+        numPaletteColors++;
+        f.palette->updateColors(colors);
+        recolor = true;
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("Remove Color"))
+      {
+        if (colors.size() > 1)
+        {
+          colors.pop_back();
+          numPaletteColors--;
+        }
+        f.palette->updateColors(colors);
+        recolor = true;
+      }
+
+      for (int i = 0; i < numPaletteColors; i++)
+      {
+        if (ImGui::ColorEdit4(
+              std::string("color " + std::to_string(i + 1)).c_str(),
+              (float*)&(colors[i]), ImGuiColorEditFlags_NoInputs))
+        {
+          f.palette->updateColors(colors);
+          recolor = true;
+        }
+      }
+    }
+    if (ImGui::SliderInt("Palette Steps", &numSteps, 10, 2000, "%d",
+                         ImGuiSliderFlags_Logarithmic))
+    {
+      // we need to make sure the number of colors
+      // divides the number of steps
+      numSteps -= (numSteps % numPaletteColors);
+      f.palette->updateSize(numSteps);
+      recolor = true;
+    }
+
+    if (ImGui::Checkbox("Interior Checks", &f.interiorChecks))
+    {
+      updateView = true;
+      f.pIterations->clear();
+    }
+    // off for renders that have to match iterating every pixel
+    if (ImGui::Checkbox("Rectangle Subdivision", &f.subdivide))
+    {
+      updateView = true;
+      f.pIterations->clear();
+    }
+
+    // julia sets have no reference orbit to perturb, the seed is c
+    if (f.deepZoom.enabled && f.type == FractalType::Mandelbrot)
+    {
+      if (ImGui::Checkbox("Perturbation", &f.deepZoom.perturbation))
+      {
+        updateView = true;
+        f.pIterations->clear();
+      }
+      if (f.deepZoom.perturbation &&
+          ImGui::Checkbox("Series Approximation",
+                          &f.deepZoom.seriesApproximation))
+      {
+        updateView = true;
+        f.pIterations->clear();
+      }
+    }
+
+    if (f.type == FractalType::Julia)
+    {
+      if (ImGui::DragFloat("Seed X", &f.seedX, 0.0005f, -2.0f, 2.0f) ||
+          ImGui::DragFloat("Seed Y", &f.seedY, 0.0005f, -2.0f, 2.0f))
+      {
+        updateView = true;
+        f.pIterations->clear();
+      }
+    }
+    ImGui::End();
+  }
+
+  if (updateView)
+  {
+    double pixelSize = (f.window.xmax - f.window.xmin) / f.imageSize.x;
+    if (pixelSize < deepZoomStart)
+      setDeepZoom(f, true);
+    else if (pixelSize > deepZoomEnd)
+      setDeepZoom(f, false);
+    if (f.deepZoom.enabled)
+      recenterDeepZoom(f);
+    updateGrid(f);
+  }
+  updateView = false;
+  if (recolor)
+    colorize(f, Int2{0, 0}, f.imageSize);
+  // whatever the background render finished since the last frame
+  if (getRenderer().publish(f) || recolor)
+  {
+    loadGrid(f);
+  }
+
+  ImGui::Image((void*)(*f.pView), ImVec2(f.imageSize.x, f.imageSize.y));
+
+  auto mousePositionAbsolute = ImGui::GetMousePos();
+  auto screenPositionAbsolute = ImGui::GetItemRectMin();
+
+  bool hovering = ImGui::IsItemHovered();
+  bool mouseDragging = ImGui::IsMouseDragging(ImGuiMouseButton_Left);
+
+  mouseX = mousePositionAbsolute.x - screenPositionAbsolute.x;
+  mouseY = mousePositionAbsolute.y - screenPositionAbsolute.y;
+
+  double complexX =
+    (mouseX * ((f.window.xmax - f.window.xmin) / f.imageSize.x)) +
+    f.window.xmin;
+  double complexY =
+    -((mouseY * ((f.window.ymax - f.window.ymin) / f.imageSize.y)) +
+      f.window.ymin);
+  // negative because the top left corner is (0,0), not the bottom left corner
+
+  static bool wasDragging = false;
+
+  if (hovering && mouseDragging)
+  {
+    // whole pixels, so the window moves exactly as far as the pixels that
+    // are kept
+    auto dragDelta = ImGui::GetMouseDragDelta();
+    int dx = (int)std::round(dragDelta.x);
+    int dy = (int)std::round(dragDelta.y);
+    if (dx != 0 || dy != 0)
+    {
+      ImGui::ResetMouseDragDelta();
+      auto complexDiffX =
+        dx * ((f.window.xmax - f.window.xmin) / f.imageSize.x);
+      auto complexDiffY =
+        dy * ((f.window.ymax - f.window.ymin) / f.imageSize.y);
+
+      f.window.xmin -= complexDiffX;
+      f.window.xmax -= complexDiffX;
+      f.window.ymin -= complexDiffY;
+      f.window.ymax -= complexDiffY;
+
+      updateView = true;
+      wasDragging = true;
+      grid.translate(dx, dy);
+      iterationBuffer.translate(dx, dy);
+    }
+  }
+  // zoom in, around an even pixel so the pixels that are kept land on the
+  // samples of the coarse passes
+  if (hovering && ImGui::IsMouseReleased(ImGuiMouseButton_Left) && !wasDragging)
+  {
+    uint32_t x = std::min(mouseX, (uint32_t)f.imageSize.x - 1) & ~1u;
+    uint32_t y = std::min(mouseY, (uint32_t)f.imageSize.y - 1) & ~1u;
+    double zoomX =
+      (x * ((f.window.xmax - f.window.xmin) / f.imageSize.x)) + f.window.xmin;
+    double zoomY =
+      -((y * ((f.window.ymax - f.window.ymin) / f.imageSize.y)) +
+        f.window.ymin);
+    f.window.xmin = (f.window.xmin + zoomX) / 2;
+    f.window.xmax = (f.window.xmax + zoomX) / 2;
+
+    f.window.ymin = (f.window.ymin - zoomY) / 2;
+    f.window.ymax = (f.window.ymax - zoomY) / 2;
+    // every other pixel of every other row is still exact, the old image
+    // scaled up shows as estimates until the rest are rendered
+    grid.zoom(x, y, true);
+    iterationBuffer.zoom(x, y, true);
+    updateView = true;
+  }
+  // zoom out, around a pixel that keeps the view on the quadtree of the tile
+  // cache
+  if (hovering && ImGui::IsMouseClicked(ImGuiMouseButton_Right))
+  {
+    uint32_t x = std::min(mouseX, (uint32_t)f.imageSize.x - 1);
+    uint32_t y = std::min(mouseY, (uint32_t)f.imageSize.y - 1);
+    TileKey key;
+    int64_t originX;
+    int64_t originY;
+    if (getTileOrigin(f, key, originX, originY))
+    {
+      if ((originX + x) & 1)
+        x = x + 1 < f.imageSize.x ? x + 1 : x - 1;
+      if ((originY + y) & 1)
+        y = y + 1 < f.imageSize.y ? y + 1 : y - 1;
+    }
+    double zoomX =
+      (x * ((f.window.xmax - f.window.xmin) / f.imageSize.x)) + f.window.xmin;
+    double zoomY =
+      -((y * ((f.window.ymax - f.window.ymin) / f.imageSize.y)) +
+        f.window.ymin);
+    f.window.xmin -= (zoomX - f.window.xmin);
+    f.window.xmax += (f.window.xmax - zoomX);
+
+    f.window.ymin += (zoomY + f.window.ymin);
+    f.window.ymax += (f.window.ymax + zoomY);
+    grid.zoom(x, y, false);
+    iterationBuffer.zoom(x, y, false);
+    updateView = true;
+  }
+
+  if (ImGui::IsMouseReleased(ImGuiMouseButton_Left && wasDragging))
+  {
+    wasDragging = false;
+  }
+
+  if (hovering && debug)
+  {
+    ImGui::Text("Screen space: x:%d, y:%d", mouseX, mouseY);
+    // the deep zoom window is relative to its center
+    double pointX = complexX;
+    double pointY = complexY;
+    if (f.deepZoom.enabled)
+    {
+      pointX += f.deepZoom.centerX.toDouble();
+      pointY -= f.deepZoom.centerY.toDouble();
+    }
+    ImGui::Text("Complex space: x:%.17g, y:%.17g", pointX, pointY);
+    ImGui::Text("Seed: (%f, %f)", f.seedX, f.seedY);
+    ImGui::Text("Value from function: %f",
+                (f.type == FractalType::Mandelbrot
+                   ? mandelbrot::calculatePixel(pointX, pointY, f.smooth,
+                                                f.maxIterations)
+                   : julia::calculatePixel(pointX, pointY, f.smooth,
+                                           f.maxIterations, f.seedX, f.seedY)));
+  }
+  if (debug)
+  {
+    const RenderStats& stats = f.stats;
+    if (stats.pass == 0)
+      ImGui::Text("Rendering first pass");
+    else if (stats.pass < stats.numPasses)
+      ImGui::Text("Rendering pass %u of %u, first image after %.1f ms",
+                  stats.pass + 1, stats.numPasses, stats.firstImageMs);
+    else
+      ImGui::Text("Rendered in %u %s, first image after %.1f ms",
+                  stats.numPasses, stats.numPasses == 1 ? "pass" : "passes",
+                  stats.firstImageMs);
+    bool perturbed = f.deepZoom.enabled && f.deepZoom.perturbation &&
+                     f.type == FractalType::Mandelbrot;
+    if (perturbed)
+      ImGui::Text("Deep zoom %.1e, %u bit center, reference orbit %u "
+                  "iterations in %.1f ms",
+                  4 / (f.window.xmax - f.window.xmin),
+                  32 * f.deepZoom.centerX.getFractionLimbs(),
+                  stats.referenceLength, stats.referenceMs);
+    else if (f.deepZoom.enabled)
+      ImGui::Text("Deep zoom %.1e, every point in %s",
+                  4 / (f.window.xmax - f.window.xmin),
+                  automata::getNumberTypeName(f.deepZoom.numberType));
+    if (perturbed && f.deepZoom.seriesApproximation &&
+        f.smooth == Smooth::Distance)
+      ImGui::Text("Series approximation unused by distance estimates");
+    else if (perturbed && f.deepZoom.seriesApproximation)
+      ImGui::Text("Series approximation skipped %u iterations, %.1fx fewer "
+                  "iterations",
+                  stats.skippedIterations, stats.seriesSpeedup);
+    if (f.interiorChecks)
+      ImGui::Text("%.1f%% pixels resolved early", stats.resolvedEarlyPercent);
+    if (f.subdivide)
+      ImGui::Text("%.1f%% pixels filled by subdivision", stats.filledPercent);
+    const TileCacheStats& cache = stats.cache;
+    uint64_t lookups = cache.hits + cache.diskHits + cache.misses;
+    ImGui::Text("Tile cache %.1f%% hits, %.1f%% from disk, %.1f MB in "
+                "memory, %.1f MB on disk",
+                lookups ? 100.0 * (cache.hits + cache.diskHits) / lookups : 0.0,
+                lookups ? 100.0 * cache.diskHits / lookups : 0.0,
+                cache.memoryBytes / 1048576.0, cache.diskBytes / 1048576.0);
+    // the render thread works through tiles too
+    uint32_t numThreads = std::thread::hardware_concurrency();
+    ImGui::Text("%s kernel, %.1f ms so far",
+                automata::getSimdLevelName(f.simdLevel), stats.wallMs);
+    ImGui::Text("%u tiles of %ux%u, %llu stolen", stats.tiles,
+                FractalRenderer::tileSize, FractalRenderer::tileSize,
+                (unsigned long long)stats.stolenTiles);
+    ImGui::Text("Tile time median %.2f ms, slowest %.2f ms, threads busy "
+                "%.0f%%",
+                stats.medianTileMs, stats.slowestTileMs,
+                stats.wallMs > 0 && numThreads > 0
+                  ? 100.0 * stats.busyMs / (stats.wallMs * numThreads)
+                  : 0.0);
+  }
+  ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
+              1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+}
+
+// should be called once per frame
+void loadGrid(FractalInfo& f)
+{
+  automata::ProfileZone zone("fractal::loadGrid");
+  if (*f.pTexture)
+    (*f.pTexture)->Release();
+  if (*f.pView)
+    (*f.pView)->Release();
+
+  automata::LoadTextureFromData(f.pGrid->getData(), f.pView, f.pTexture,
+                                f.pDevice, f.imageSize.x, f.imageSize.y);
+}
+
+void updateGrid(FractalInfo& f)
+{
+  getRenderer().start(f);
+  // nothing to show until the first tiles come back
+  if (!*f.pView)
+    loadGrid(f);
+}
+} // namespace fractal
@@ -1,296 +1,137 @@
 #include "Gradient.hpp"
 
-#include "imgui/imgui.h"
-#include "utils/LoadTextureFromData.hpp"
+#include "utils/Profiler.hpp"
+#include "utils/ThreadPool.hpp"
 
-#include <d3d11.h>
+#include <algorithm>
 #include <random>
 #include <string>
+#include <thread>
+
+namespace
+{
+// a shade that only depends on the generation and the cell, so a step comes
+// out the same however the rows are split between threads
+uint8_t randomShade(uint64_t generation, uint64_t cell)
+{
+  uint64_t x = (generation << 32) ^ cell;
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return (x ^ (x >> 31)) % 255;
+}
+} // namespace
 
 Gradient::Gradient(uint64_t height, uint64_t width, uint32_t scale,
                  ID3D11Device* pDevice)
   : m_height(height),
     m_width(width),
     m_grid(width, height),
-    m_upsampledGrid(width * scale, height * scale),
     m_rule(std::make_pair(510, 765), std::make_pair(255, 765)),
     m_defaultRule(std::make_pair(510, 765), std::make_pair(255, 765)),
     m_scale(scale),
     m_neighborhoodSize(8),
     m_presetRules(),
     m_wrap(true),
-    m_pDevice(pDevice),
-    m_texture(NULL),
-    m_view(NULL)
+    m_numThreads(std::max(1u, std::thread::hardware_concurrency())),
+    m_generation(0),
+    m_plane(width, height),
+    m_pDevice(pDevice)
 {
-  loadGrid();
+  // the presenter is made the first time the window shows
+  m_grid.enableBackBuffer();
 }
 
-void Gradient::showAutomataWindow()
+void Gradient::step()
 {
-  static int timer = 0;
-  static int timerReset = 0;
-  static bool displayRuleMenu = false;
-  static bool running = false;
-  static bool drawClick = false;
-
-  if (ImGui::Button("Show Rule Editor"))
-    displayRuleMenu = true;
-
-  if (displayRuleMenu)
-    showRuleMenu(displayRuleMenu);
-
-  ImGui::Checkbox("Wrap edges", &m_wrap);
-
-  if (running)
-  {
-    if (ImGui::Button("Stop"))
-      running = false;
-    ImGui::SameLine();
-    if (ImGui::Button("Reset"))
-      resetGrid();
-  }
-  else
-  {
-    if (ImGui::Button("Start"))
+  automata::ProfileZone zone("Gradient::step");
+  auto loadRows = [&](uint64_t begin, uint64_t end) {
+    for (int64_t h = begin; h < (int64_t)end; h++)
     {
-      resetGrid();
-      running = true;
-    }
-    ImGui::SameLine();
-    if (ImGui::Button("Step"))
-      updateGrid();
-    ImGui::SameLine();
-    if (ImGui::Button("Resume"))
-      running = true;
-  }
- 
-  ImGui::SliderInt("Simulation Speed", &timerReset, 0, 60);
-  if (timer > timerReset && running)
-  {
-    updateGrid();
-    timer = 0;
-  }
-  if (running)
-    timer++;
-
-   ImGui::Image((void*)m_view, ImVec2(m_grid.getWidth() * m_scale,
-                                      m_grid.getHeight() * m_scale));
-  /*
-  bool isHovered = ImGui::IsItemHovered();
-  ImVec2 mousePositionAbsolute = ImGui::GetMousePos();
-  ImVec2 screenPositionAbsolute = ImGui::GetItemRectMin();
-  ImVec2 mousePositionRelative =
-    ImVec2(mousePositionAbsolute.x - screenPositionAbsolute.x,
-           mousePositionAbsolute.y - screenPositionAbsolute.y);
-  if (ImGui::IsMouseDown(ImGuiMouseButton_Left) && isHovered &&
-      mousePositionRelative.x < m_scale * m_width &&
-      mousePositionRelative.x >= 0 &&
-      mousePositionRelative.y < m_scale * m_height &&
-      mousePositionRelative.y >= 0)
-  { // did the user click on the grid?
-    m_grid.setCell(mousePositionRelative.y / m_scale,
-                   mousePositionRelative.x / m_scale,
-                   Color{255, 255, 255, 255});
-    m_grid.applyChanges();
-    upsampleGrid(m_grid, m_upsampledGrid, m_scale);
-    loadGrid();
-  }
-  ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
-              1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-
-  ImDrawList* draw_list = ImGui::GetWindowDrawList();
-  draw_list->AddImage(m_view, ImVec2(1, 100), ImVec2(1, 100));
-  */
-}
-
-void Gradient::showRuleMenu(bool& show)
-{
-  ImGuiWindowFlags flags = 0;
-  flags |= ImGuiWindowFlags_AlwaysAutoResize;
-  flags |= ImGuiWindowFlags_NoResize;
-  ImGui::Begin("Rule Editor", &show, flags);
-
-  static int neighborhoodSelected = 0;
-  if (ImGui::Combo("Neighborhood Size", &neighborhoodSelected,
-                   "Moore distance 1\0"
-                   "Moore Distance 2\0"
-                   "Von Neumann 1\0"
-                   "Von Neumann 2\0"
-                   "Weighted\0\0"))
-  {
-    switch (neighborhoodSelected)
-    {
-    case 0:
-      m_neighborhoodSize = 8;
-      break;
-    case 1:
-      m_neighborhoodSize = 24;
-      break;
-    case 2:
-      m_neighborhoodSize = 4;
-      break;
-    case 3:
-      m_neighborhoodSize = 12;
-      break;
-    case 4:
-      m_neighborhoodSize = 16;
+      uint8_t* cells = m_plane.getRow(h);
+      for (int64_t w = 0; w < m_width; w++)
+      {
+        auto color = m_grid.getCell(h, w);
+        // the average of rgb values
+        cells[w] = ((uint32_t)color.r + color.b + color.g) / 3;
+      }
     }
-  }
-
-  if (ImGui::Button("Reset rule to default"))
-    m_rule = m_defaultRule;
-
-  ImGui::DragIntRange2("Birth", &m_rule.m_birthConditions.first,
-                       &m_rule.m_birthConditions.second, 1.0f, 0,
-                       255 * m_neighborhoodSize);
-  ImGui::DragIntRange2("Survive", &m_rule.m_surviveConditions.first,
-                       &m_rule.m_surviveConditions.second, 1.0f, 0,
-                       255 * m_neighborhoodSize);
-  ImGui::Text("Valid range: %d to %d", 0, 255 * m_neighborhoodSize);
-
-  ImGui::End();
+  };
+  auto& pool = automata::ThreadPool::getShared();
+  pool.forEachBand(m_height, m_numThreads, loadRows);
+  m_plane.updateBorder(m_wrap);
+
+  // the bands write the next generation into the back buffer
+  pool.forEachBand(m_height, m_numThreads,
+                   [&](uint64_t begin, uint64_t end) {
+                     stepRows(begin, end);
+                   });
+  m_grid.swapBuffers();
+  m_generation++;
 }
 
-void Gradient::loadGrid()
-{
-  if (m_texture)
-    m_texture->Release();
-  if (m_view)
-    m_view->Release();
-
-  automata::LoadTextureFromData(m_upsampledGrid.getData(), &m_view, &m_texture,
-                                m_pDevice, m_width * m_scale,
-                                m_height * m_scale);
-}
-
-void Gradient::updateGrid()
+void Gradient::stepRows(int64_t begin, int64_t end)
 {
   Color dead = {0, 0, 0, 0};
-  Color alive = {255, 255, 255, 255};
+  std::vector<uint16_t> sums(m_width);
 
-  for (uint32_t h = 0; h < m_height; h++)
+  for (int64_t h = begin; h < end; h++)
   {
-    for (uint32_t w = 0; w < m_width; w++)
+    neighbors::sumRow(m_plane, h, m_neighborhoodSize, sums.data(),
+                      automata::getSimdLevel());
+    for (int64_t w = 0; w < m_width; w++)
     {
-      uint32_t aliveNeighbors = countNeighbors(h, w);
+      uint32_t aliveNeighbors = sums[w];
       if (m_grid.checkCell(h, w))
       { // if the cell is alive
-        if (!m_rule.survived(aliveNeighbors))
-        {
-          m_grid.setCell(h, w, dead);
-        }
+        if (m_rule.survived(aliveNeighbors))
+          m_grid.setBackCell(h, w, m_grid.getCell(h, w));
+        else
+          m_grid.setBackCell(h, w, dead);
       }
       else
       { // is the cell is dead
         if (m_rule.born(aliveNeighbors))
         {
-          uint8_t g = rand() % 255;
-          m_grid.setCell(h, w, Color{g, g, g, 255});
+          uint8_t g = randomShade(m_generation, h * m_width + w);
+          m_grid.setBackCell(h, w, Color{g, g, g, 255});
+        }
+        else
+        {
+          m_grid.setBackCell(h, w, dead);
         }
       }
     }
   }
-  m_grid.applyChanges();
-  upsampleGrid(m_grid, m_upsampledGrid, m_scale);
-  loadGrid();
 }
 
-void Gradient::resetGrid()
+void Gradient::randomize()
 {
-  Color white{255, 255, 255, 255};
   m_grid.clear();
-  m_upsampledGrid.clear();
   for (uint32_t h = 0; h < m_height; h++)
   {
     for (uint32_t w = 0; w < m_width; w++)
     {
       uint8_t g = rand() % 255;
-      m_grid.setCell(h, w, Color{g, g, g, 255});
+      m_grid.setCellDirectly(h, w, Color{g, g, g, 255});
     }
   }
-  m_grid.applyChanges();
-  upsampleGrid(m_grid, m_upsampledGrid, m_scale);
-  loadGrid();
 }
 
-uint32_t Gradient::countNeighbors(int32_t height, int32_t width)
+void Gradient::publish()
 {
-  if (m_neighborhoodSize == 8)
-    return checkCell(height - 1, width - 1) + checkCell(height - 1, width) +
-           checkCell(height - 1, width + 1) + checkCell(height, width - 1) +
-           checkCell(height, width + 1) + checkCell(height + 1, width - 1) +
-           checkCell(height + 1, width) + checkCell(height + 1, width + 1);
-  else if (m_neighborhoodSize == 24)
-    return checkCell(height - 1, width - 1) + checkCell(height - 1, width) +
-           checkCell(height - 1, width + 1) + checkCell(height, width - 1) +
-           checkCell(height, width + 1) + checkCell(height + 1, width - 1) +
-           checkCell(height + 1, width) + checkCell(height + 1, width + 1) +
-           checkCell(height - 2, width - 2) + checkCell(height - 2, width - 1) +
-           checkCell(height - 2, width) + checkCell(height - 2, width + 1) +
-           checkCell(height - 2, width + 2) + checkCell(height - 1, width - 2) +
-           checkCell(height - 1, width + 2) + checkCell(height, width - 2) +
-           checkCell(height, width + 2) + checkCell(height + 1, width - 2) +
-           checkCell(height + 1, width + 2) + checkCell(height + 2, width - 2) +
-           checkCell(height + 2, width - 1) + checkCell(height + 2, width) +
-           checkCell(height + 2, width + 1) + checkCell(height + 2, width + 2);
-  else if (m_neighborhoodSize == 4)
-    return checkCell(height - 1, width) + checkCell(height, width - 1) +
-           checkCell(height + 1, width) + checkCell(height, width + 1);
-  else if (m_neighborhoodSize == 12)
-    return checkCell(height - 2, width) + checkCell(height - 1, width - 1) +
-           checkCell(height - 1, width) + checkCell(height - 1, width + 1) +
-           checkCell(height, width - 2) + checkCell(height, width - 1) +
-           checkCell(height, width + 1) + checkCell(height, width + 2) +
-           checkCell(height + 1, width - 1) + checkCell(height + 1, width) +
-           checkCell(height + 1, width + 1) + checkCell(height + 2, width);
-  else if (m_neighborhoodSize == 16) // inner 8 cells have twice the weight
-    return (2 * checkCell(height - 1, width - 1) +
-            2 * checkCell(height - 1, width) +
-            2 * checkCell(height - 1, width + 1) +
-            2 * checkCell(height, width - 1) +
-            2 * checkCell(height, width + 1) +
-            2 * checkCell(height + 1, width - 1) +
-            2 * checkCell(height + 1, width) +
-            2 * checkCell(height + 1, width + 1) +
-            checkCell(height - 2, width - 2) +
-            checkCell(height - 2, width - 1) + checkCell(height - 2, width) +
-            checkCell(height - 2, width + 1) +
-            checkCell(height - 2, width + 2) +
-            checkCell(height - 1, width - 2) +
-            checkCell(height - 1, width + 2) + checkCell(height, width - 2) +
-            checkCell(height, width + 2) + checkCell(height + 1, width - 2) +
-            checkCell(height + 1, width + 2) +
-            checkCell(height + 2, width - 2) +
-            checkCell(height + 2, width - 1) + checkCell(height + 2, width) +
-            checkCell(height + 2, width + 1) +
-            checkCell(height + 2, width + 2)) /
-           2;
-  else
-    return 0;
+  if (m_presenter)
+    m_presenter->publish(m_grid);
 }
 
-uint32_t Gradient::checkCell(int32_t row, int32_t col)
+void Gradient::updateGrid()
 {
-  int32_t r = row;
-  int32_t c = col;
-  if (m_wrap)
-  {
-    if (row <= -1)
-      r = m_height + row;
-    if (row >= m_height)
-      r = row - m_height;
-    if (col <= -1)
-      c = m_width + col;
-    if (col >= m_width)
-      c = col - m_width;
-  }
-  else
-  {
-    if (row < 0 || row >= m_height || col < 0 || col >= m_width)
-      return false;
-  }
-  auto color = m_grid.getCell(r, c);
-  // return the average of rgb values
-  return ((uint32_t)color.r + color.b + color.g) / 3;
+  step();
+  publish();
+}
+
+void Gradient::resetGrid()
+{
+  randomize();
+  publish();
 }
@@ -2,10 +2,13 @@
 #define AUTOMATA_GRADIENT
 
 #include "Grid.hpp"
+#include "NeighborKernel.hpp"
+#include "Presenter.hpp"
+#include "utils/D3D11Forward.hpp"
 
-#include <d3d11.h>  
 #include <set>
 #include <map>
+#include <memory>
 
 struct GradientRule
 {
@@ -38,30 +41,61 @@ public:
 
   void showRuleMenu(bool& show);
 
-  void loadGrid();
+  // hands m_grid to the presenter, if there is one yet
+  void publish();
 
+  void setPresenter(std::unique_ptr<Presenter> presenter)
+  {
+    m_presenter = std::move(presenter);
+  }
+
+  // step, then publishes the new generation
   void updateGrid();
 
+  // randomize, then publishes it
   void resetGrid();
 
-  uint32_t countNeighbors(int32_t height, int32_t width);
+  // one generation into m_grid, nothing is published
+  void step();
+
+  // every cell a random shade of gray
+  void randomize();
+
+  void setRule(const GradientRule& rule, uint32_t neighborhoodSize)
+  {
+    m_rule = rule;
+    m_neighborhoodSize = neighborhoodSize;
+  }
+
+  void setNumThreads(uint32_t numThreads)
+  {
+    m_numThreads = numThreads;
+  }
+
+  Grid& getGrid()
+  {
+    return m_grid;
+  }
 
-  uint32_t checkCell(int32_t row, int32_t col);
+  // one band of a step, reads m_plane and the front buffer of m_grid and
+  // writes the back buffer
+  void stepRows(int64_t begin, int64_t end);
 
 private:
   int64_t m_height;
   int64_t m_width;
   Grid m_grid;
-  Grid m_upsampledGrid;
   GradientRule m_rule;
   GradientRule m_defaultRule;
   uint32_t m_scale;
   uint32_t m_neighborhoodSize;
   std::map<std::string, GradientRule> m_presetRules;
   bool m_wrap;
+  uint32_t m_numThreads; // horizontal bands stepped in parallel
+  uint64_t m_generation;
+  CellPlane m_plane; // average of each cell's rgb values
   ID3D11Device* m_pDevice;
-  ID3D11ShaderResourceView* m_view;
-  ID3D11Texture2D* m_texture;
+  std::unique_ptr<Presenter> m_presenter;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "Gradient.hpp"
+#include "TexturePresenter.hpp"
+
+#include "imgui/imgui.h"
+#include "utils/Profiler.hpp"
+
+#include <algorithm>
+#include <thread>
+
+void Gradient::showAutomataWindow()
+{
+  automata::ProfileZone zone("Gradient::showAutomataWindow");
+  static int timer = 0;
+  static int timerReset = 0;
+  static bool displayRuleMenu = false;
+  static bool running = false;
+  static bool drawClick = false;
+
+  if (!m_presenter)
+  {
+    setPresenter(std::unique_ptr<Presenter>(new TexturePresenter(m_pDevice)));
+    publish();
+  }
+
+  if (ImGui::Button("Show Rule Editor"))
+    displayRuleMenu = true;
+
+  if (displayRuleMenu)
+    showRuleMenu(displayRuleMenu);
+
+  ImGui::Checkbox("Wrap edges", &m_wrap);
+
+  int numThreads = m_numThreads;
+  if (ImGui::SliderInt("Threads", &numThreads, 1,
+                       std::max(1u, std::thread::hardware_concurrency())))
+    m_numThreads = numThreads;
+
+  if (running)
+  {
+    if (ImGui::Button("Stop"))
+      running = false;
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+      resetGrid();
+  }
+  else
+  {
+    if (ImGui::Button("Start"))
+    {
+      resetGrid();
+      running = true;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Step"))
+      updateGrid();
+    ImGui::SameLine();
+    if (ImGui::Button("Resume"))
+      running = true;
+  }
+ 
+  ImGui::SliderInt("Simulation Speed", &timerReset, 0, 60);
+  if (timer > timerReset && running)
+  {
+    updateGrid();
+    timer = 0;
+  }
+  if (running)
+    timer++;
+
+  m_presenter->present(m_scale);
+  /*
+  bool isHovered = ImGui::IsItemHovered();
+  ImVec2 mousePositionAbsolute = ImGui::GetMousePos();
+  ImVec2 screenPositionAbsolute = ImGui::GetItemRectMin();
+  ImVec2 mousePositionRelative =
+    ImVec2(mousePositionAbsolute.x - screenPositionAbsolute.x,
+           mousePositionAbsolute.y - screenPositionAbsolute.y);
+  if (ImGui::IsMouseDown(ImGuiMouseButton_Left) && isHovered &&
+      mousePositionRelative.x < m_scale * m_width &&
+      mousePositionRelative.x >= 0 &&
+      mousePositionRelative.y < m_scale * m_height &&
+      mousePositionRelative.y >= 0)
+  { // did the user click on the grid?
+    m_grid.setCell(mousePositionRelative.y / m_scale,
+                   mousePositionRelative.x / m_scale,
+                   Color{255, 255, 255, 255});
+    m_grid.applyChanges();
+    publish();
+  }
+  ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
+              1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+  */
+}
+
+void Gradient::showRuleMenu(bool& show)
+{
+  ImGuiWindowFlags flags = 0;
+  flags |= ImGuiWindowFlags_AlwaysAutoResize;
+  flags |= ImGuiWindowFlags_NoResize;
+  ImGui::Begin("Rule Editor", &show, flags);
+
+  static int neighborhoodSelected = 0;
+  if (ImGui::Combo("Neighborhood Size", &neighborhoodSelected,
+                   "Moore distance 1\0"
+                   "Moore Distance 2\0"
+                   "Von Neumann 1\0"
+                   "Von Neumann 2\0"
+                   "Weighted\0\0"))
+  {
+    switch (neighborhoodSelected)
+    {
+    case 0:
+      m_neighborhoodSize = 8;
+      break;
+    case 1:
+      m_neighborhoodSize = 24;
+      break;
+    case 2:
+      m_neighborhoodSize = 4;
+      break;
+    case 3:
+      m_neighborhoodSize = 12;
+      break;
+    case 4:
+      m_neighborhoodSize = 16;
+    }
+  }
+
+  if (ImGui::Button("Reset rule to default"))
+    m_rule = m_defaultRule;
+
+  ImGui::DragIntRange2("Birth", &m_rule.m_birthConditions.first,
+                       &m_rule.m_birthConditions.second, 1.0f, 0,
+                       255 * m_neighborhoodSize);
+  ImGui::DragIntRange2("Survive", &m_rule.m_surviveConditions.first,
+                       &m_rule.m_surviveConditions.second, 1.0f, 0,
+                       255 * m_neighborhoodSize);
+  ImGui::Text("Valid range: %d to %d", 0, 255 * m_neighborhoodSize);
+
+  ImGui::End();
+}
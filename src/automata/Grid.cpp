@@ -1,5 +1,17 @@
 #include "Grid.hpp"
 
+#include "utils/Profiler.hpp"
+#include "utils/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+// bytes of upsampled image below which upsampleGrid stays on one thread
+const uint64_t minBandBytes = 1 << 20;
+} // namespace
+
 bool Grid::setCellDirectly(uint64_t row, uint64_t col, Color color)
 {
   if (row >= m_height || col >= m_width || !m_data.arr.data())
@@ -39,69 +51,171 @@ bool Grid::checkCell(uint64_t row, uint64_t col)
 
 void Grid::translate(int dx, int dy)
 {
-  if (dx != 0 || dy != 0)
-  {
-    Grid newGrid(m_width, m_height);
-    for (uint32_t x = 0; x < m_width; x++)
-    {
-      for (uint32_t y = 0; y < m_height; y++)
-      {
-        Color c = getCell(y, x);
+  const Color empty{0, 0, 0, 0};
+  scrollImage(getData(), m_width, m_height, 4, dx, dy, &empty);
+}
 
-        uint32_t newX = x + dx;
-        uint32_t newY = y + dy;
-        if (!(newX >= m_width || newX < 0 || newY >= m_height || newY < 0))
-        {
-          newGrid.setCellDirectly(newY, newX, c);
-        }
-      }
-    }
-    std::memcpy(getData(), newGrid.getData(), m_height * m_width * 4);
-  }
+void Grid::zoom(uint32_t x, uint32_t y, bool in)
+{
+  const Color empty{0, 0, 0, 0};
+  zoomImage(getData(), m_width, m_height, 4, x, y, in, in ? nullptr : &empty);
 }
 
 void Grid::clear()
 {
   m_data.fill(0);
+  if (m_back.len)
+    m_back.fill(0);
   m_changes.clear();
 }
 
 void Grid::applyChanges()
 {
+  // setCell already checked the bounds
   for (const auto& change : m_changes)
   {
-    m_data.set((change.row * m_width + change.col) * 4, change.color.r);
-    m_data.set((change.row * m_width + change.col) * 4 + 1, change.color.g);
-    m_data.set((change.row * m_width + change.col) * 4 + 2, change.color.b);
-    m_data.set((change.row * m_width + change.col) * 4 + 3, change.color.a);
+    std::memcpy(getData() + (change.row * m_width + change.col) * 4,
+                &change.color, 4);
   }
   m_changes.clear();
 }
 
-void upsampleGrid(Grid& unit, Grid& scaled, uint32_t scale)
+void Grid::enableBackBuffer()
 {
-  uint32_t unitWidth = unit.getWidth();
-  uint32_t unitHeight = unit.getHeight();
-  uint32_t stride = unit.getWidth() * 4 * scale;
+  if (m_back.len != m_data.len)
+    m_back = Buffer(m_data.len);
+}
 
-  for (uint64_t h = 0; h < unitHeight; h++)
-  {
-    for (uint64_t w = 0; w < unitWidth; w++)
-    {
-      Color color = unit.getCell(h, w);
-      uint32_t c = color.r | ((uint32_t)color.g << 8) |
-                   ((uint32_t)color.b << 16) | ((uint32_t)color.a << 24);
+void upsampleGrid(Grid& unit, Grid& scaled, uint32_t scale,
+                  automata::SimdLevel level)
+{
+  automata::ProfileZone zone("upsampleGrid");
+  uint64_t unitWidth = unit.getWidth();
+  uint64_t unitHeight = unit.getHeight();
+  if (scale == 0 || scaled.getWidth() < unitWidth * scale ||
+      scaled.getHeight() < unitHeight * scale)
+    return;
+  uint64_t unitStride = unitWidth * 4;
+  uint64_t stride = scaled.getWidth() * 4;
+  uint64_t rowBytes = unitStride * scale;
+  const uint8_t* in = unit.getData();
+  uint8_t* out = scaled.getData();
 
-      uint32_t offset = (h * stride * scale) + (w * scale * 4);
-      for (uint64_t sy = 0; sy < scale; sy++)
+  auto upsampleRows = [&](uint64_t begin, uint64_t end) {
+    for (uint64_t h = begin; h < end; h++)
+    {
+      const uint8_t* row = in + h * unitStride;
+      uint8_t* block = out + h * scale * stride;
+      uint64_t done = 0;
+#ifdef AUTOMATA_X86
+      if (level >= automata::SimdLevel::Avx2)
+        done = widenRowAvx2(row, block, unitWidth, scale);
+#endif
+      widenRowScalar(row, block, done, unitWidth, scale);
+      // the rest of the block from the rows already in it, doubling each
+      // time. Padding past unitWidth * scale isn't touched
+      if (rowBytes == stride)
       {
-        for (uint64_t sx = 0; sx < scale; sx++)
+        for (uint64_t filled = 1; filled < scale;)
         {
-          std::memcpy(scaled.getData() + offset +
-                        (stride * sy) + (sx * 4),
-                      &c, 4);
+          uint64_t rows = std::min<uint64_t>(filled, scale - filled);
+          std::memcpy(block + filled * stride, block, rows * stride);
+          filled += rows;
         }
       }
+      else
+      {
+        for (uint64_t sy = 1; sy < scale; sy++)
+          std::memcpy(block + sy * stride, block, rowBytes);
+      }
+    }
+  };
+
+  // a band has to be worth waking a thread for
+  auto& pool = automata::ThreadPool::getShared();
+  uint64_t bands = std::min<uint64_t>(pool.getNumThreads() + 1,
+                                      unitHeight * scale * stride /
+                                        minBandBytes);
+  if (bands <= 1)
+    upsampleRows(0, unitHeight);
+  else
+    pool.forEachBand(unitHeight, bands, upsampleRows);
+}
+
+void widenRowScalar(const uint8_t* in, uint8_t* out, uint64_t start,
+                    uint64_t count, uint32_t scale)
+{
+  for (uint64_t w = start; w < count; w++)
+  {
+    uint32_t cell;
+    std::memcpy(&cell, in + w * 4, 4);
+    uint8_t* block = out + w * scale * 4;
+    for (uint32_t sx = 0; sx < scale; sx++)
+      std::memcpy(block + sx * 4, &cell, 4);
+  }
+}
+
+void scrollImage(uint8_t* data, uint64_t width, uint64_t height,
+                 uint32_t cellSize, int64_t dx, int64_t dy, const void* fill)
+{
+  if (dx == 0 && dy == 0)
+    return;
+  int64_t w = width;
+  int64_t h = height;
+  uint64_t rowBytes = width * cellSize;
+  auto fillCells = [&](uint8_t* cells, int64_t count) {
+    for (int64_t i = 0; i < count; i++)
+      std::memcpy(cells + i * cellSize, fill, cellSize);
+  };
+  if (dx <= -w || dx >= w || dy <= -h || dy >= h)
+  {
+    fillCells(data, w * h);
+    return;
+  }
+
+  // rows going down are moved bottom first and rows going up top first, so
+  // every row is read before it is written over
+  int64_t cols = w - std::abs(dx);
+  int64_t from = std::max<int64_t>(0, -dx);
+  int64_t to = std::max<int64_t>(0, dx);
+  for (int64_t k = 0; k < h - std::abs(dy); k++)
+  {
+    int64_t y = dy > 0 ? h - 1 - k : k;
+    uint8_t* row = data + y * rowBytes;
+    const uint8_t* source = data + (y - dy) * rowBytes;
+    std::memmove(row + to * cellSize, source + from * cellSize,
+                 cols * cellSize);
+    fillCells(row + (dx > 0 ? 0 : cols) * cellSize, std::abs(dx));
+  }
+  fillCells(data + (dy > 0 ? 0 : h + dy) * rowBytes, std::abs(dy) * w);
+}
+
+void zoomImage(uint8_t* data, uint64_t width, uint64_t height,
+               uint32_t cellSize, uint32_t x, uint32_t y, bool in,
+               const void* fill)
+{
+  std::vector<uint8_t> old(data, data + width * height * cellSize);
+  // where a new column or row was in the old image, -1 if it wasn't on an
+  // old cell. (i + x) / 2 < width for any x < width
+  auto getSource = [&](int64_t i, int64_t center, int64_t size) -> int64_t {
+    if (in)
+      return (i + center) % 2 == 0 || !fill ? (i + center) / 2 : -1;
+    int64_t source = 2 * i - center;
+    return source >= 0 && source < size ? source : -1;
+  };
+  std::vector<int64_t> columns(width);
+  for (uint64_t i = 0; i < width; i++)
+    columns[i] = getSource(i, x, width);
+  for (uint64_t row = 0; row < height; row++)
+  {
+    int64_t sourceRow = getSource(row, y, height);
+    uint8_t* cells = data + row * width * cellSize;
+    for (uint64_t i = 0; i < width; i++)
+    {
+      const void* cell = fill;
+      if (sourceRow >= 0 && columns[i] >= 0)
+        cell = old.data() + (sourceRow * width + columns[i]) * cellSize;
+      std::memcpy(cells + i * cellSize, cell, cellSize);
     }
   }
 }
@@ -1,7 +1,10 @@
 #ifndef AUTOMATA_GRID
 #define AUTOMATA_GRID
 
+#include "utils/CpuFeatures.hpp"
+
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <stdexcept>
 #include <vector>
@@ -49,7 +52,7 @@ class Grid
 {
 public:
   Grid(uint64_t width, uint64_t height)
-    : m_width(width), m_height(height), m_data(width * height * 4)
+    : m_width(width), m_height(height), m_data(width * height * 4), m_back(0)
   {
     m_data.fill(0);
   }
@@ -70,6 +73,7 @@ public:
 
   Color getCell(uint64_t row, uint64_t col);
 
+  // queued until applyChanges, meant for sparse edits like mouse painting
   bool setCell(uint64_t row, uint64_t col, Color color);
 
   bool setCellDirectly(uint64_t row, uint64_t col, Color color);
@@ -89,11 +93,41 @@ public:
 
   void clear();
 
+  // moves every cell by (dx, dy) in place, what comes in at the edges is
+  // empty
   void translate(int dx, int dy);
 
+  // zooms 2x in or out around cell (x, y), see zoomImage. Zooming in, the
+  // new cells show the old one they are in
+  void zoom(uint32_t x, uint32_t y, bool in);
+
   void applyChanges();
 
+  // a second buffer the next generation is written into while this one is
+  // still being read. Every cell of it has to be written before swapping
+  void enableBackBuffer();
+
+  uint8_t* getBackData()
+  {
+    return m_back.arr.data();
+  }
+
+  bool setBackCell(uint64_t row, uint64_t col, Color color)
+  {
+    if (row >= m_height || col >= m_width)
+      return false;
+    std::memcpy(m_back.arr.data() + (row * m_width + col) * 4, &color, 4);
+    return true;
+  }
+
+  // makes the back buffer current, the old generation becomes the back
+  void swapBuffers()
+  {
+    std::swap(m_data, m_back);
+  }
+
   Buffer m_data;
+  Buffer m_back; // empty until enableBackBuffer
 
   struct CellChange
   {
@@ -108,6 +142,34 @@ private:
   uint64_t m_height;
 };
 
-void upsampleGrid(Grid& unit, Grid& scaled, uint32_t scale);
+// every cell of unit as a scale x scale block of scaled, which has to be at
+// least scale times as big. Each row is widened once and copied to the rest
+// of its block, and big grids are split into bands of rows on the shared
+// thread pool
+void upsampleGrid(Grid& unit, Grid& scaled, uint32_t scale,
+                  automata::SimdLevel level = automata::getSimdLevel());
+
+// the isa specific bodies of upsampleGrid, each of the count 4 byte cells of
+// in repeated scale times in out
+void widenRowScalar(const uint8_t* in, uint8_t* out, uint64_t start,
+                    uint64_t count, uint32_t scale);
+// only for scales up to 8, returns how many cells it widened
+uint64_t widenRowAvx2(const uint8_t* in, uint8_t* out, uint64_t count,
+                      uint32_t scale);
+
+// moves the cells of a width x height image by (dx, dy) in place, a row at a
+// time. The cells that come in at the edges are set to the cellSize bytes at
+// fill
+void scrollImage(uint8_t* data, uint64_t width, uint64_t height,
+                 uint32_t cellSize, int64_t dx, int64_t dy, const void* fill);
+
+// zooms a width x height image 2x in or out around cell (x, y), which stays
+// where it is. Zooming in, cell (col, row) moves to (2 col - x, 2 row - y)
+// and the cells in between are set to fill, or to the old cell they are in
+// if fill is null. Zooming out, every other cell moves to ((col + x) / 2,
+// (row + y) / 2) and the cells outside the old image are set to fill
+void zoomImage(uint8_t* data, uint64_t width, uint64_t height,
+               uint32_t cellSize, uint32_t x, uint32_t y, bool in,
+               const void* fill);
 
 #endif
@@ -0,0 +1,32 @@
+#include "Grid.hpp"
+
+#ifdef AUTOMATA_X86
+#include <immintrin.h>
+
+uint64_t widenRowAvx2(const uint8_t* in, uint8_t* out, uint64_t count,
+                      uint32_t scale)
+{
+  if (scale > 8)
+    return 0;
+  // 8 cells come out as scale vectors, lane j of vector k is cell
+  // (8k + j) / scale
+  __m256i lanes[8];
+  for (uint32_t k = 0; k < scale; k++)
+  {
+    alignas(32) int32_t index[8];
+    for (uint32_t j = 0; j < 8; j++)
+      index[j] = (8 * k + j) / scale;
+    lanes[k] = _mm256_load_si256((const __m256i*)index);
+  }
+  uint64_t w = 0;
+  for (; w + 8 <= count; w += 8)
+  {
+    __m256i cells = _mm256_loadu_si256((const __m256i*)(in + w * 4));
+    __m256i* block = (__m256i*)(out + w * scale * 4);
+    for (uint32_t k = 0; k < scale; k++)
+      _mm256_storeu_si256(block + k,
+                          _mm256_permutevar8x32_epi32(cells, lanes[k]));
+  }
+  return w;
+}
+#endif
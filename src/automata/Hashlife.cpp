@@ -0,0 +1,473 @@
+#include "Hashlife.hpp"
+
+#include <algorithm>
+
+namespace
+{
+const uint32_t noNode = 0xffffffff;
+
+uint64_t hashChildren(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+{
+  uint64_t h = nw;
+  h = h * 0x9e3779b97f4a7c15ull + ne;
+  h = h * 0x9e3779b97f4a7c15ull + sw;
+  h = h * 0x9e3779b97f4a7c15ull + se;
+  h ^= h >> 29;
+  h *= 0xbf58476d1ce4e5b9ull;
+  return h ^ (h >> 32);
+}
+} // namespace
+
+Hashlife::Hashlife(uint64_t memoryLimit)
+  : m_freeList(noNode),
+    m_liveNodes(0),
+    m_root(noNode),
+    m_generation(0),
+    m_memoryLimit(memoryLimit),
+    m_stats()
+{
+  clear();
+  std::set<uint8_t> birth{3};
+  std::set<uint8_t> survive{2, 3};
+  Rule life(birth, survive);
+  setRule(life);
+}
+
+void Hashlife::clear()
+{
+  m_nodes.clear();
+  m_buckets.assign(1 << 16, noNode);
+  m_empty.clear();
+  m_freeList = noNode;
+
+  Node leaf{noNode, noNode, noNode, noNode, noNode, noNode, 0, 0, -1,
+            false,  false};
+  m_nodes.push_back(leaf);
+  leaf.population = 1;
+  m_nodes.push_back(leaf);
+  m_liveNodes = 2;
+  m_empty.push_back(0);
+
+  m_root = getEmpty(3);
+  m_generation = 0;
+}
+
+void Hashlife::setRule(Rule& rule)
+{
+  std::vector<uint8_t> transitions(rule.m_moore, rule.m_moore + 512);
+  // b0 would fill the empty plane every generation, which an empty node
+  // cannot represent, so it is ignored
+  transitions[0] = 0;
+  if (transitions == m_transitions)
+    return;
+
+  m_transitions = transitions;
+  // every memoized future was computed with the old rule
+  for (auto& node : m_nodes)
+    node.result = noNode;
+}
+
+uint32_t Hashlife::getNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+{
+  m_stats.lookups++;
+  uint64_t bucket = hashChildren(nw, ne, sw, se) & (m_buckets.size() - 1);
+  for (uint32_t i = m_buckets[bucket]; i != noNode; i = m_nodes[i].next)
+  {
+    const Node& node = m_nodes[i];
+    if (node.nw == nw && node.ne == ne && node.sw == sw && node.se == se)
+    {
+      m_stats.lookupHits++;
+      return i;
+    }
+  }
+
+  Node node{nw,
+            ne,
+            sw,
+            se,
+            noNode,
+            m_buckets[bucket],
+            m_nodes[nw].population + m_nodes[ne].population +
+              m_nodes[sw].population + m_nodes[se].population,
+            (uint8_t)(m_nodes[nw].level + 1),
+            -1,
+            false,
+            false};
+  uint32_t index;
+  if (m_freeList != noNode)
+  {
+    index = m_freeList;
+    m_freeList = m_nodes[index].next;
+    m_nodes[index] = node;
+  }
+  else
+  {
+    index = m_nodes.size();
+    m_nodes.push_back(node);
+  }
+  m_buckets[bucket] = index;
+  m_liveNodes++;
+  if (m_liveNodes > m_buckets.size())
+    rehash(m_buckets.size() * 2);
+  return index;
+}
+
+uint32_t Hashlife::getEmpty(uint32_t level)
+{
+  while (m_empty.size() <= level)
+  {
+    uint32_t e = m_empty.back();
+    m_empty.push_back(getNode(e, e, e, e));
+  }
+  return m_empty[level];
+}
+
+uint32_t Hashlife::expand(uint32_t index)
+{
+  Node node = m_nodes[index];
+  uint32_t e = getEmpty(node.level - 1);
+  return getNode(getNode(e, e, e, node.nw), getNode(e, e, node.ne, e),
+                 getNode(e, node.sw, e, e), getNode(node.se, e, e, e));
+}
+
+bool Hashlife::isPadded(uint32_t index)
+{
+  const Node& node = m_nodes[index];
+  if (node.level < 3)
+    return false;
+  const Node& nw = m_nodes[node.nw];
+  const Node& ne = m_nodes[node.ne];
+  const Node& sw = m_nodes[node.sw];
+  const Node& se = m_nodes[node.se];
+  // is every live cell inside the centre quarter?
+  uint64_t centre = m_nodes[m_nodes[nw.se].se].population +
+                    m_nodes[m_nodes[ne.sw].sw].population +
+                    m_nodes[m_nodes[sw.ne].ne].population +
+                    m_nodes[m_nodes[se.nw].nw].population;
+  return centre == node.population;
+}
+
+// the centre half of a level 2 node one generation ahead
+uint32_t Hashlife::successorBase(uint32_t index)
+{
+  const Node& node = m_nodes[index];
+  uint32_t quadrants[4] = {node.nw, node.ne, node.sw, node.se};
+  bool cells[4][4];
+  for (uint32_t y = 0; y < 4; y++)
+  {
+    for (uint32_t x = 0; x < 4; x++)
+    {
+      const Node& q = m_nodes[quadrants[(y / 2) * 2 + x / 2]];
+      uint32_t leaves[4] = {q.nw, q.ne, q.sw, q.se};
+      cells[y][x] = leaves[(y % 2) * 2 + x % 2] == 1;
+    }
+  }
+
+  uint32_t next[4];
+  for (uint32_t y = 1; y <= 2; y++)
+  {
+    for (uint32_t x = 1; x <= 2; x++)
+    {
+      uint32_t pattern = 0;
+      for (int32_t dy = -1; dy <= 1; dy++)
+        for (int32_t dx = -1; dx <= 1; dx++)
+          if (cells[y + dy][x + dx])
+            pattern |= 1 << Rule::getPatternBit(dy, dx);
+      next[(y - 1) * 2 + (x - 1)] = m_transitions[pattern];
+    }
+  }
+  return getNode(next[0], next[1], next[2], next[3]);
+}
+
+// the centre half of a node, 2^step generations ahead. step is capped at
+// level - 2, the furthest the node's own cells can determine
+uint32_t Hashlife::successor(uint32_t index, uint32_t step)
+{
+  // copied, getNode may grow m_nodes under a reference
+  Node node = m_nodes[index];
+  uint32_t level = node.level;
+  step = std::min(step, level - 2);
+  if (node.result != noNode && node.resultStep == (int8_t)step)
+  {
+    m_stats.resultHits++;
+    return node.result;
+  }
+  m_stats.resultMisses++;
+
+  uint32_t result;
+  if (node.population == 0)
+  {
+    result = getEmpty(level - 1);
+  }
+  else if (level == 2)
+  {
+    result = successorBase(index);
+  }
+  else
+  {
+    Node nw = m_nodes[node.nw];
+    Node ne = m_nodes[node.ne];
+    Node sw = m_nodes[node.sw];
+    Node se = m_nodes[node.se];
+
+    // nine overlapping nodes one level down, each advanced on its own
+    uint32_t parts[9] = {node.nw,
+                         getNode(nw.ne, ne.nw, nw.se, ne.sw),
+                         node.ne,
+                         getNode(nw.sw, nw.se, sw.nw, sw.ne),
+                         getNode(nw.se, ne.sw, sw.ne, se.nw),
+                         getNode(ne.sw, ne.se, se.nw, se.ne),
+                         node.sw,
+                         getNode(sw.ne, se.nw, sw.se, se.sw),
+                         node.se};
+    uint32_t r[9];
+    for (uint32_t i = 0; i < 9; i++)
+      r[i] = successor(parts[i], step);
+
+    if (step < level - 2)
+    {
+      // already far enough ahead, take the centres of the results
+      Node q[9];
+      for (uint32_t i = 0; i < 9; i++)
+        q[i] = m_nodes[r[i]];
+      uint32_t a = getNode(q[0].se, q[1].sw, q[3].ne, q[4].nw);
+      uint32_t b = getNode(q[1].se, q[2].sw, q[4].ne, q[5].nw);
+      uint32_t c = getNode(q[3].se, q[4].sw, q[6].ne, q[7].nw);
+      uint32_t d = getNode(q[4].se, q[5].sw, q[7].ne, q[8].nw);
+      result = getNode(a, b, c, d);
+    }
+    else
+    {
+      // a second round of successors makes up the other half of the step
+      uint32_t a = successor(getNode(r[0], r[1], r[3], r[4]), step);
+      uint32_t b = successor(getNode(r[1], r[2], r[4], r[5]), step);
+      uint32_t c = successor(getNode(r[3], r[4], r[6], r[7]), step);
+      uint32_t d = successor(getNode(r[4], r[5], r[7], r[8]), step);
+      result = getNode(a, b, c, d);
+    }
+  }
+
+  m_nodes[index].result = result;
+  m_nodes[index].resultStep = step;
+  return result;
+}
+
+void Hashlife::step(uint32_t exponent)
+{
+  // only the centre half survives a successor, so pad until the pattern sits
+  // in the centre quarter with room to travel for 2^exponent generations
+  while (m_nodes[m_root].level < exponent + 3 || !isPadded(m_root))
+    m_root = expand(m_root);
+  m_root = successor(m_root, exponent);
+  m_generation += 1ull << exponent;
+
+  if (getMemoryUsed() > m_memoryLimit)
+    collectGarbage();
+}
+
+uint32_t Hashlife::setCell(uint32_t index, int64_t x, int64_t y, bool alive)
+{
+  Node node = m_nodes[index];
+  if (node.level == 0)
+    return alive ? 1 : 0;
+
+  // coordinates are relative to the node's centre
+  int64_t quarter = node.level >= 2 ? 1ll << (node.level - 2) : 0;
+  int64_t childX = x < 0 ? x + quarter : x - quarter;
+  int64_t childY = y < 0 ? y + quarter : y - quarter;
+  if (y < 0)
+  {
+    if (x < 0)
+      node.nw = setCell(node.nw, childX, childY, alive);
+    else
+      node.ne = setCell(node.ne, childX, childY, alive);
+  }
+  else
+  {
+    if (x < 0)
+      node.sw = setCell(node.sw, childX, childY, alive);
+    else
+      node.se = setCell(node.se, childX, childY, alive);
+  }
+  return getNode(node.nw, node.ne, node.sw, node.se);
+}
+
+void Hashlife::setCell(int64_t x, int64_t y, bool alive)
+{
+  for (;;)
+  {
+    int64_t half = 1ll << (m_nodes[m_root].level - 1);
+    if (x >= -half && x < half && y >= -half && y < half)
+      break;
+    m_root = expand(m_root);
+  }
+  m_root = setCell(m_root, x, y, alive);
+}
+
+bool Hashlife::getCell(int64_t x, int64_t y)
+{
+  uint32_t index = m_root;
+  int64_t half = 1ll << (m_nodes[index].level - 1);
+  if (x < -half || x >= half || y < -half || y >= half)
+    return false;
+  while (m_nodes[index].level > 0)
+  {
+    const Node& node = m_nodes[index];
+    int64_t quarter = node.level >= 2 ? 1ll << (node.level - 2) : 0;
+    if (y < 0)
+      index = x < 0 ? node.nw : node.ne;
+    else
+      index = x < 0 ? node.sw : node.se;
+    x = x < 0 ? x + quarter : x - quarter;
+    y = y < 0 ? y + quarter : y - quarter;
+  }
+  return index == 1;
+}
+
+void Hashlife::load(Grid& grid, int64_t x, int64_t y)
+{
+  for (uint64_t row = 0; row < grid.getHeight(); row++)
+  {
+    for (uint64_t col = 0; col < grid.getWidth(); col++)
+    {
+      if (grid.checkCell(row, col))
+        setCell(x + col, y + row, true);
+    }
+  }
+}
+
+void Hashlife::renderNode(Grid& grid, uint32_t index, int64_t x, int64_t y,
+                          int64_t left, int64_t top, uint32_t zoom,
+                          Color alive)
+{
+  const Node& node = m_nodes[index];
+  if (node.population == 0)
+    return;
+  int64_t size = 1ll << node.level;
+  int64_t right = left + ((int64_t)grid.getWidth() << zoom);
+  int64_t bottom = top + ((int64_t)grid.getHeight() << zoom);
+  if (x >= right || y >= bottom || x + size <= left || y + size <= top)
+    return;
+
+  if (node.level <= zoom)
+  { // the whole node falls inside one pixel
+    grid.setCellDirectly((y - top) >> zoom, (x - left) >> zoom, alive);
+    return;
+  }
+  int64_t half = size / 2;
+  renderNode(grid, node.nw, x, y, left, top, zoom, alive);
+  renderNode(grid, node.ne, x + half, y, left, top, zoom, alive);
+  renderNode(grid, node.sw, x, y + half, left, top, zoom, alive);
+  renderNode(grid, node.se, x + half, y + half, left, top, zoom, alive);
+}
+
+void Hashlife::render(Grid& grid, int64_t left, int64_t top, uint32_t zoom,
+                      Color alive)
+{
+  int64_t pixel = 1ll << zoom;
+  // floor to the pixel lattice so nodes never straddle two pixels
+  left -= ((left % pixel) + pixel) % pixel;
+  top -= ((top % pixel) + pixel) % pixel;
+
+  grid.clear();
+  int64_t half = 1ll << (m_nodes[m_root].level - 1);
+  renderNode(grid, m_root, -half, -half, left, top, zoom, alive);
+}
+
+void Hashlife::collect(bool keepResults)
+{
+  std::vector<uint32_t> stack(m_empty.begin(), m_empty.end());
+  stack.push_back(m_root);
+  stack.push_back(1);
+  while (!stack.empty())
+  {
+    uint32_t index = stack.back();
+    stack.pop_back();
+    Node& node = m_nodes[index];
+    if (node.marked)
+      continue;
+    node.marked = true;
+    if (node.level > 0)
+    {
+      stack.push_back(node.nw);
+      stack.push_back(node.ne);
+      stack.push_back(node.sw);
+      stack.push_back(node.se);
+    }
+    if (keepResults && node.result != noNode)
+      stack.push_back(node.result);
+  }
+
+  for (auto& node : m_nodes)
+  {
+    if (node.marked && node.result != noNode && !m_nodes[node.result].marked)
+      node.result = noNode;
+  }
+
+  uint64_t collected = 0;
+  for (uint32_t i = 0; i < m_nodes.size(); i++)
+  {
+    Node& node = m_nodes[i];
+    if (node.marked)
+    {
+      node.marked = false;
+    }
+    else if (!node.free)
+    {
+      node.free = true;
+      node.result = noNode;
+      node.next = m_freeList;
+      m_freeList = i;
+      collected++;
+    }
+  }
+  m_liveNodes -= collected;
+  m_stats.collections++;
+  m_stats.lastCollected = collected;
+  rehash(m_buckets.size());
+}
+
+void Hashlife::collectGarbage()
+{
+  collect(true);
+  // the memoized successors can be rebuilt, the pattern cannot
+  if (getMemoryUsed() > m_memoryLimit / 2)
+  {
+    uint64_t collected = m_stats.lastCollected;
+    collect(false);
+    m_stats.collections--;
+    m_stats.lastCollected += collected;
+  }
+}
+
+void Hashlife::rehash(uint64_t numBuckets)
+{
+  m_buckets.assign(numBuckets, noNode);
+  // the leaves are never looked up
+  for (uint32_t i = 2; i < m_nodes.size(); i++)
+  {
+    Node& node = m_nodes[i];
+    if (node.free)
+      continue;
+    uint64_t bucket =
+      hashChildren(node.nw, node.ne, node.sw, node.se) & (numBuckets - 1);
+    node.next = m_buckets[bucket];
+    m_buckets[bucket] = i;
+  }
+}
+
+uint64_t Hashlife::getMemoryUsed()
+{
+  return m_liveNodes * sizeof(Node) + m_buckets.size() * sizeof(uint32_t);
+}
+
+HashlifeStats Hashlife::getStats()
+{
+  HashlifeStats stats = m_stats;
+  stats.liveNodes = m_liveNodes;
+  stats.reservedNodes = m_nodes.size();
+  stats.buckets = m_buckets.size();
+  stats.memoryUsed = getMemoryUsed();
+  stats.memoryLimit = m_memoryLimit;
+  return stats;
+}
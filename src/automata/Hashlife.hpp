@@ -0,0 +1,128 @@
+#ifndef AUTOMATA_HASHLIFE
+#define AUTOMATA_HASHLIFE
+
+#include "Grid.hpp"
+#include "Rule.hpp"
+
+#include <cstdint>
+#include <vector>
+
+struct HashlifeStats
+{
+  uint64_t liveNodes;
+  uint64_t reservedNodes; // slots in the node pool, live or free
+  uint64_t buckets;
+  uint64_t memoryUsed;    // bytes taken by live nodes and the bucket array
+  uint64_t memoryLimit;
+  uint64_t lookups;       // canonicalizing node lookups
+  uint64_t lookupHits;    // lookups that found an existing node
+  uint64_t resultHits;    // memoized successors reused
+  uint64_t resultMisses;
+  uint64_t collections;
+  uint64_t lastCollected; // nodes freed by the last collection
+};
+
+// memoized quadtree life on an unbounded plane. Every distinct square of
+// cells is stored once, and each node caches the centre of its future, so
+// repetitive patterns can be advanced by 2^k generations at a time.
+// Only range 1 Moore (8 neighbor) rules without b0 can be run this way,
+// isotropic non-totalistic ones included.
+class Hashlife
+{
+public:
+  Hashlife(uint64_t memoryLimit);
+
+  void clear();
+
+  void setRule(Rule& rule);
+
+  // cell coordinates are unbounded, (0, 0) is the centre of the universe
+  void setCell(int64_t x, int64_t y, bool alive);
+
+  bool getCell(int64_t x, int64_t y);
+
+  // places every live cell of the grid with its top left corner at (x, y)
+  void load(Grid& grid, int64_t x, int64_t y);
+
+  // advance by 2^exponent generations
+  void step(uint32_t exponent);
+
+  // draws the cells starting at (left, top) into the grid, each pixel
+  // covering 2^zoom by 2^zoom cells. left and top are rounded down to a
+  // multiple of 2^zoom
+  void render(Grid& grid, int64_t left, int64_t top, uint32_t zoom,
+              Color alive);
+
+  // frees nodes unreachable from the current pattern. The memoized
+  // successors are dropped too when they alone would overrun the limit
+  void collectGarbage();
+
+  void setMemoryLimit(uint64_t bytes)
+  {
+    m_memoryLimit = bytes;
+  }
+
+  uint64_t getGeneration()
+  {
+    return m_generation;
+  }
+
+  uint64_t getPopulation()
+  {
+    return m_nodes[m_root].population;
+  }
+
+  HashlifeStats getStats();
+
+private:
+  struct Node
+  {
+    uint32_t nw;
+    uint32_t ne;
+    uint32_t sw;
+    uint32_t se;
+    uint32_t result; // memoized successor, noNode if not yet computed
+    uint32_t next;   // hash chain, or free list once freed
+    uint64_t population;
+    uint8_t level;   // the node is 2^level cells square
+    int8_t resultStep;
+    bool marked;
+    bool free;
+  };
+
+  uint32_t getNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+
+  uint32_t getEmpty(uint32_t level);
+
+  uint32_t expand(uint32_t index);
+
+  bool isPadded(uint32_t index);
+
+  uint32_t successor(uint32_t index, uint32_t step);
+
+  uint32_t successorBase(uint32_t index);
+
+  uint32_t setCell(uint32_t index, int64_t x, int64_t y, bool alive);
+
+  void renderNode(Grid& grid, uint32_t index, int64_t x, int64_t y,
+                  int64_t left, int64_t top, uint32_t zoom, Color alive);
+
+  void collect(bool keepResults);
+
+  void rehash(uint64_t numBuckets);
+
+  uint64_t getMemoryUsed();
+
+  std::vector<Node> m_nodes; // 0 and 1 are the dead and alive leaves
+  std::vector<uint32_t> m_buckets;
+  std::vector<uint32_t> m_empty; // the empty node of each level
+  uint32_t m_freeList;
+  uint64_t m_liveNodes;
+  uint32_t m_root;
+  uint64_t m_generation;
+  std::vector<uint8_t> m_transitions; // Rule::next of every 3x3 pattern
+  uint64_t m_memoryLimit;
+  HashlifeStats m_stats;
+};
+
+#endif
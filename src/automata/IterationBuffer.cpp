@@ -0,0 +1,30 @@
+#include "IterationBuffer.hpp"
+#include "Grid.hpp"
+
+#include <algorithm>
+
+void IterationBuffer::clear()
+{
+  std::fill(m_values.begin(), m_values.end(), std::nanf(""));
+  std::fill(m_exact.begin(), m_exact.end(), 0);
+}
+
+void IterationBuffer::translate(int dx, int dy)
+{
+  const float unknown = std::nanf("");
+  const uint8_t inexact = 0;
+  scrollImage((uint8_t*)m_values.data(), m_width, m_height, sizeof(float), dx,
+              dy, &unknown);
+  scrollImage(m_exact.data(), m_width, m_height, 1, dx, dy, &inexact);
+}
+
+void IterationBuffer::zoom(uint32_t x, uint32_t y, bool in)
+{
+  const float unknown = std::nanf("");
+  const uint8_t inexact = 0;
+  // zooming in, the pixels between the kept ones show the old value they
+  // grew out of as an estimate
+  zoomImage((uint8_t*)m_values.data(), m_width, m_height, sizeof(float), x, y,
+            in, in ? nullptr : &unknown);
+  zoomImage(m_exact.data(), m_width, m_height, 1, x, y, in, &inexact);
+}
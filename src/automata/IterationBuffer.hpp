@@ -0,0 +1,103 @@
+#ifndef AUTOMATA_ITERATION_BUFFER
+#define AUTOMATA_ITERATION_BUFFER
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// what calculatePixel gave each pixel of a fractal image, NaN where it hasn't
+// been iterated yet. The image's colors are worked out from these, so a new
+// palette only has to be colorized rather than iterated again. A value can
+// also be an estimate, like the sample a coarse pass shows over its whole
+// block, which is colorized the same but still has to be rendered
+class IterationBuffer
+{
+public:
+  IterationBuffer(uint32_t width, uint32_t height)
+    : m_width(width), m_height(height),
+      m_values((uint64_t)width * height, std::nanf("")),
+      m_exact((uint64_t)width * height, 0)
+  {
+  }
+
+  uint32_t getWidth() const
+  {
+    return m_width;
+  }
+
+  uint32_t getHeight() const
+  {
+    return m_height;
+  }
+
+  // rows of getWidth values, top first
+  float* getData()
+  {
+    return m_values.data();
+  }
+
+  const float* getData() const
+  {
+    return m_values.data();
+  }
+
+  // 1 where the value at the same place in getData is exact
+  uint8_t* getExactData()
+  {
+    return m_exact.data();
+  }
+
+  const uint8_t* getExactData() const
+  {
+    return m_exact.data();
+  }
+
+  float get(uint32_t row, uint32_t col) const
+  {
+    return m_values[(uint64_t)row * m_width + col];
+  }
+
+  // an exact value
+  void set(uint32_t row, uint32_t col, float value)
+  {
+    m_values[(uint64_t)row * m_width + col] = value;
+    m_exact[(uint64_t)row * m_width + col] = 1;
+  }
+
+  // a value to show until the exact one is rendered
+  void setEstimate(uint32_t row, uint32_t col, float value)
+  {
+    m_values[(uint64_t)row * m_width + col] = value;
+    m_exact[(uint64_t)row * m_width + col] = 0;
+  }
+
+  // has a value to colorize, exact or not
+  bool isKnown(uint32_t row, uint32_t col) const
+  {
+    return !std::isnan(get(row, col));
+  }
+
+  bool isExact(uint32_t row, uint32_t col) const
+  {
+    return m_exact[(uint64_t)row * m_width + col];
+  }
+
+  void clear();
+
+  // moves every value and whether it's exact by (dx, dy) in place, what
+  // comes in at the edges is unknown
+  void translate(int dx, int dy);
+
+  // zooms 2x in or out around pixel (x, y). The values that still land on a
+  // pixel are kept. Zooming in, the rest are the old values scaled up as
+  // estimates, zooming out they are unknown. See zoomImage
+  void zoom(uint32_t x, uint32_t y, bool in);
+
+private:
+  uint32_t m_width;
+  uint32_t m_height;
+  std::vector<float> m_values;
+  std::vector<uint8_t> m_exact;
+};
+
+#endif
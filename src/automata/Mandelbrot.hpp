@@ -5,13 +5,19 @@
 #include "Palette.hpp"
 #include "Fractal.hpp"
 
-#include <d3d11.h>
-
-#include <imgui/imgui.h>
 namespace mandelbrot
 {
   double calculatePixel(const double x_0, const double y_0, const Smooth smooth,
                         const uint32_t maxIterations);
+
+  // for zooms past what doubles can place, instantiated for DoubleDouble,
+  // QuadDouble and BigFixed. pixelSize is the spacing of the points around
+  // it, which the interior checks scale with
+  template <typename Number>
+  double calculatePixel(const Number& x_0, const Number& y_0,
+                        const Smooth smooth, const uint32_t maxIterations,
+                        const bool interiorChecks = false,
+                        const double pixelSize = 0);
 };
 
 #endif
@@ -0,0 +1,133 @@
+#include "NeighborKernel.hpp"
+#include "Neighborhood.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+CellPlane::CellPlane(uint64_t width, uint64_t height)
+  : m_width(width),
+    m_height(height),
+    m_stride(width + 2 * margin),
+    m_cells(m_stride * (height + 2 * margin), 0)
+{
+}
+
+void CellPlane::updateBorder(bool wrap)
+{
+  int64_t width = m_width;
+  int64_t height = m_height;
+  for (int64_t row = 0; row < height; row++)
+  {
+    uint8_t* cells = getRow(row);
+    for (int64_t col = 1; col <= margin; col++)
+    {
+      cells[-col] = wrap ? cells[((-col % width) + width) % width] : 0;
+      cells[width - 1 + col] = wrap ? cells[(col - 1) % width] : 0;
+    }
+  }
+  // whole padded rows, so the corners come along
+  for (int64_t row = 1; row <= margin; row++)
+  {
+    uint8_t* above = getRow(-row) - margin;
+    uint8_t* below = getRow(height - 1 + row) - margin;
+    if (wrap)
+    {
+      std::memcpy(above, getRow(((-row % height) + height) % height) - margin,
+                  m_stride);
+      std::memcpy(below, getRow((row - 1) % height) - margin, m_stride);
+    }
+    else
+    {
+      std::memset(above, 0, m_stride);
+      std::memset(below, 0, m_stride);
+    }
+  }
+}
+
+namespace neighbors
+{
+namespace
+{
+struct RowSources
+{
+  const uint8_t* rows[24];
+  uint32_t weights[24];
+  KernelArgs args;
+};
+
+void getSources(const CellPlane& plane, int64_t row, uint64_t col,
+                uint64_t count, uint32_t neighborhoodSize, RowSources& sources)
+{
+  std::vector<NeighborOffset> offsets = getNeighborhood(neighborhoodSize);
+  for (size_t k = 0; k < offsets.size(); k++)
+  {
+    sources.rows[k] =
+      plane.getRow(row + offsets[k].dy) + (int64_t)col + offsets[k].dx;
+    sources.weights[k] = offsets[k].weight;
+  }
+  sources.args.rows = sources.rows;
+  sources.args.weights = sources.weights;
+  sources.args.count = offsets.size();
+  sources.args.width = count;
+  sources.args.shift = getNeighborhoodDivisor(neighborhoodSize) == 2 ? 1 : 0;
+}
+} // namespace
+
+void countRow(const CellPlane& plane, int64_t row, uint32_t neighborhoodSize,
+              uint8_t* out, automata::SimdLevel level)
+{
+  countSpan(plane, row, 0, plane.getWidth(), neighborhoodSize, out, level);
+}
+
+void countSpan(const CellPlane& plane, int64_t row, uint64_t col,
+               uint64_t count, uint32_t neighborhoodSize, uint8_t* out,
+               automata::SimdLevel level)
+{
+  RowSources sources;
+  getSources(plane, row, col, count, neighborhoodSize, sources);
+#ifdef AUTOMATA_X86
+  if (level >= automata::SimdLevel::Avx2)
+    return countRowAvx2(sources.args, out);
+  if (level >= automata::SimdLevel::Sse41)
+    return countRowSse41(sources.args, out);
+#endif
+  countRowScalar(sources.args, 0, out);
+}
+
+void sumRow(const CellPlane& plane, int64_t row, uint32_t neighborhoodSize,
+            uint16_t* out, automata::SimdLevel level)
+{
+  RowSources sources;
+  getSources(plane, row, 0, plane.getWidth(), neighborhoodSize, sources);
+#ifdef AUTOMATA_X86
+  if (level >= automata::SimdLevel::Avx2)
+    return sumRowAvx2(sources.args, out);
+  if (level >= automata::SimdLevel::Sse41)
+    return sumRowSse41(sources.args, out);
+#endif
+  sumRowScalar(sources.args, 0, out);
+}
+
+void countRowScalar(const KernelArgs& args, uint64_t start, uint8_t* out)
+{
+  for (uint64_t x = start; x < args.width; x++)
+  {
+    uint32_t sum = 0;
+    for (size_t k = 0; k < args.count; k++)
+      sum += args.weights[k] * args.rows[k][x];
+    // matches the saturating adds of the vector kernels
+    out[x] = std::min(sum, 255u) >> args.shift;
+  }
+}
+
+void sumRowScalar(const KernelArgs& args, uint64_t start, uint16_t* out)
+{
+  for (uint64_t x = start; x < args.width; x++)
+  {
+    uint32_t sum = 0;
+    for (size_t k = 0; k < args.count; k++)
+      sum += args.weights[k] * args.rows[k][x];
+    out[x] = sum >> args.shift;
+  }
+}
+} // namespace neighbors
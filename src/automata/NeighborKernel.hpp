@@ -0,0 +1,85 @@
+#ifndef AUTOMATA_NEIGHBOR_KERNEL
+#define AUTOMATA_NEIGHBOR_KERNEL
+
+#include "utils/CpuFeatures.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// one byte per cell with a border of 'margin' cells on every side, so the
+// kernels can read every neighbor of an edge cell without wrap arithmetic
+class CellPlane
+{
+public:
+  static const int64_t margin = 2;
+
+  CellPlane(uint64_t width, uint64_t height);
+
+  // row may be anywhere in [-margin, height + margin)
+  uint8_t* getRow(int64_t row)
+  {
+    return m_cells.data() + (row + margin) * m_stride + margin;
+  }
+
+  const uint8_t* getRow(int64_t row) const
+  {
+    return m_cells.data() + (row + margin) * m_stride + margin;
+  }
+
+  // copies the opposite edges into the border, or clears it
+  void updateBorder(bool wrap);
+
+  uint64_t getWidth() const
+  {
+    return m_width;
+  }
+  uint64_t getHeight() const
+  {
+    return m_height;
+  }
+
+private:
+  uint64_t m_width;
+  uint64_t m_height;
+  uint64_t m_stride;
+  std::vector<uint8_t> m_cells;
+};
+
+namespace neighbors
+{
+// live neighbors of every cell in a row for cells holding 0 or 1, the same
+// shapes and weighting as the rule editor's neighborhood sizes
+void countRow(const CellPlane& plane, int64_t row, uint32_t neighborhoodSize,
+              uint8_t* out, automata::SimdLevel level);
+
+// countRow for the cells [col, col + count) of a row, out[0] is cell col
+void countSpan(const CellPlane& plane, int64_t row, uint64_t col,
+               uint64_t count, uint32_t neighborhoodSize, uint8_t* out,
+               automata::SimdLevel level);
+
+// neighbor values summed without saturating, for cells holding 0 to 255
+void sumRow(const CellPlane& plane, int64_t row, uint32_t neighborhoodSize,
+            uint16_t* out, automata::SimdLevel level);
+
+// what the isa specific bodies below see: one source pointer per neighbor,
+// already offset to that neighbor of the row's first cell
+struct KernelArgs
+{
+  const uint8_t* const* rows;
+  const uint32_t* weights;
+  size_t count;
+  uint64_t width;
+  uint32_t shift; // 1 halves the weighted neighborhood
+};
+
+void countRowScalar(const KernelArgs& args, uint64_t start, uint8_t* out);
+void countRowSse41(const KernelArgs& args, uint8_t* out);
+void countRowAvx2(const KernelArgs& args, uint8_t* out);
+
+void sumRowScalar(const KernelArgs& args, uint64_t start, uint16_t* out);
+void sumRowSse41(const KernelArgs& args, uint16_t* out);
+void sumRowAvx2(const KernelArgs& args, uint16_t* out);
+} // namespace neighbors
+
+#endif
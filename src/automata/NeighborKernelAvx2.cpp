@@ -0,0 +1,51 @@
+#include "NeighborKernel.hpp"
+
+#ifdef AUTOMATA_X86
+#include <immintrin.h>
+
+namespace neighbors
+{
+void countRowAvx2(const KernelArgs& args, uint8_t* out)
+{
+  const __m256i lowSeven = _mm256_set1_epi8(0x7f);
+  uint64_t x = 0;
+  for (; x + 32 <= args.width; x += 32)
+  {
+    __m256i sum = _mm256_setzero_si256();
+    for (size_t k = 0; k < args.count; k++)
+    {
+      __m256i cells = _mm256_loadu_si256((const __m256i*)(args.rows[k] + x));
+      sum = _mm256_adds_epu8(sum, cells);
+      if (args.weights[k] == 2)
+        sum = _mm256_adds_epu8(sum, cells);
+    }
+    if (args.shift)
+      sum = _mm256_and_si256(_mm256_srli_epi16(sum, 1), lowSeven);
+    _mm256_storeu_si256((__m256i*)(out + x), sum);
+  }
+  countRowScalar(args, x, out);
+}
+
+void sumRowAvx2(const KernelArgs& args, uint16_t* out)
+{
+  uint64_t x = 0;
+  for (; x + 16 <= args.width; x += 16)
+  {
+    __m256i sum = _mm256_setzero_si256();
+    for (size_t k = 0; k < args.count; k++)
+    {
+      __m256i cells = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128((const __m128i*)(args.rows[k] + x)));
+      if (args.weights[k] == 2)
+        cells = _mm256_slli_epi16(cells, 1);
+      sum = _mm256_add_epi16(sum, cells);
+    }
+    if (args.shift)
+      sum = _mm256_srli_epi16(sum, 1);
+    _mm256_storeu_si256((__m256i*)(out + x), sum);
+  }
+  sumRowScalar(args, x, out);
+}
+} // namespace neighbors
+
+#endif
@@ -0,0 +1,51 @@
+#include "NeighborKernel.hpp"
+
+#ifdef AUTOMATA_X86
+#include <smmintrin.h>
+
+namespace neighbors
+{
+void countRowSse41(const KernelArgs& args, uint8_t* out)
+{
+  const __m128i lowSeven = _mm_set1_epi8(0x7f);
+  uint64_t x = 0;
+  for (; x + 16 <= args.width; x += 16)
+  {
+    __m128i sum = _mm_setzero_si128();
+    for (size_t k = 0; k < args.count; k++)
+    {
+      __m128i cells = _mm_loadu_si128((const __m128i*)(args.rows[k] + x));
+      sum = _mm_adds_epu8(sum, cells);
+      if (args.weights[k] == 2)
+        sum = _mm_adds_epu8(sum, cells);
+    }
+    if (args.shift)
+      sum = _mm_and_si128(_mm_srli_epi16(sum, 1), lowSeven);
+    _mm_storeu_si128((__m128i*)(out + x), sum);
+  }
+  countRowScalar(args, x, out);
+}
+
+void sumRowSse41(const KernelArgs& args, uint16_t* out)
+{
+  uint64_t x = 0;
+  for (; x + 8 <= args.width; x += 8)
+  {
+    __m128i sum = _mm_setzero_si128();
+    for (size_t k = 0; k < args.count; k++)
+    {
+      __m128i cells = _mm_cvtepu8_epi16(
+        _mm_loadl_epi64((const __m128i*)(args.rows[k] + x)));
+      if (args.weights[k] == 2)
+        cells = _mm_slli_epi16(cells, 1);
+      sum = _mm_add_epi16(sum, cells);
+    }
+    if (args.shift)
+      sum = _mm_srli_epi16(sum, 1);
+    _mm_storeu_si128((__m128i*)(out + x), sum);
+  }
+  sumRowScalar(args, x, out);
+}
+} // namespace neighbors
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef AUTOMATA_NEIGHBORHOOD
+#define AUTOMATA_NEIGHBORHOOD
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+struct NeighborOffset
+{
+  int32_t dy;
+  int32_t dx;
+  uint32_t weight;
+};
+
+// the same shapes Conways::countNeighbors walks, as a list of offsets.
+// the weighted neighborhood (16) sums with these weights and is then halved
+inline std::vector<NeighborOffset> getNeighborhood(uint32_t neighborhoodSize)
+{
+  std::vector<NeighborOffset> offsets;
+  switch (neighborhoodSize)
+  {
+  case 4:
+    offsets = {{-1, 0, 1}, {0, -1, 1}, {1, 0, 1}, {0, 1, 1}};
+    break;
+  case 8:
+    for (int32_t dy = -1; dy <= 1; dy++)
+      for (int32_t dx = -1; dx <= 1; dx++)
+        if (dy != 0 || dx != 0)
+          offsets.push_back({dy, dx, 1});
+    break;
+  case 12:
+    for (int32_t dy = -2; dy <= 2; dy++)
+      for (int32_t dx = -2; dx <= 2; dx++)
+        if ((dy != 0 || dx != 0) && std::abs(dy) + std::abs(dx) <= 2)
+          offsets.push_back({dy, dx, 1});
+    break;
+  case 16:
+  case 24:
+    for (int32_t dy = -2; dy <= 2; dy++)
+      for (int32_t dx = -2; dx <= 2; dx++)
+        if (dy != 0 || dx != 0)
+        {
+          bool inner = std::abs(dy) <= 1 && std::abs(dx) <= 1;
+          uint32_t weight = (neighborhoodSize == 16 && inner) ? 2 : 1;
+          offsets.push_back({dy, dx, weight});
+        }
+    break;
+  }
+  return offsets;
+}
+
+inline uint32_t getNeighborhoodDivisor(uint32_t neighborhoodSize)
+{
+  return neighborhoodSize == 16 ? 2 : 1;
+}
+
+#endif
@@ -1,18 +1,10 @@
 #include "Palette.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace
 {
-double fmod(double f, uint32_t n)
-{
-  for (;;)
-  { // could be infinite if f < 0
-    if (f - n >= 0)
-      f -= n;
-    else
-      return f;
-  }
-}
-
   // assumed that 'interval' is between 0 and 1
 Color interpolate(const Color& color1, const Color& color2, const float interval)
 {
@@ -35,13 +27,20 @@ Color imvec4ToColor(ImVec4 vec)
 // index is assumed to be (numIterations + gradient)
 Color Palette::getColor(double index)
 {
-  index = fmod(index, m_numSteps);
-  uint32_t numColors = m_colors.size();
-  uint32_t stepSize = m_numSteps / numColors;
-  uint32_t colorIndex1 = index / stepSize;
-  return interpolate(m_colors[colorIndex1],
-                     m_colors[(colorIndex1 + 1) % numColors],
-                     fmod(index, stepSize) / stepSize);
+  float position = index;
+  Color color{};
+  colorizeScalar(getTable(), &position, &color, 0, 1);
+  return color;
+}
+
+void Palette::colorize(const float* indices, Color* out, uint32_t count,
+                       automata::SimdLevel level) const
+{
+#ifdef AUTOMATA_X86
+  if (level >= automata::SimdLevel::Avx2)
+    return colorizeAvx2(getTable(), indices, out, count);
+#endif
+  colorizeScalar(getTable(), indices, out, 0, count);
 }
 
 void Palette::updateColors(std::vector<ImVec4> colors)
@@ -51,4 +50,41 @@ void Palette::updateColors(std::vector<ImVec4> colors)
   {
     m_colors.push_back(imvec4ToColor(color));
   }
+  bakeTable();
+}
+
+void Palette::bakeTable()
+{
+  // each color fades into the next over stepSize steps, the last one back
+  // into the first
+  uint32_t numColors = m_colors.size();
+  uint32_t stepSize = std::max(1u, m_numSteps / numColors);
+  m_table.resize(std::max(1u, m_numSteps * tableResolution));
+  for (uint32_t i = 0; i < m_table.size(); i++)
+  {
+    double index = (double)i / tableResolution;
+    uint32_t colorIndex1 =
+      std::min((uint32_t)(index / stepSize), numColors - 1);
+    double interval = (index - colorIndex1 * stepSize) / stepSize;
+    m_table[i] = interpolate(m_colors[colorIndex1],
+                             m_colors[(colorIndex1 + 1) % numColors],
+                             std::min(interval, 1.0));
+  }
+}
+
+void colorizeScalar(const PaletteTable& table, const float* indices,
+                    Color* out, uint32_t start, uint32_t count)
+{
+  int32_t last = table.size - 1;
+  for (uint32_t i = start; i < count; i++)
+  {
+    if (std::isnan(indices[i]))
+      continue;
+    // wrapped in floats the way colorizeAvx2 does, so both pick the same
+    // entry
+    float position = indices[i] * Palette::tableResolution;
+    position -= std::floor(position * table.inverseSize) * table.size;
+    int32_t entry = std::min(std::max((int32_t)position, 0), last);
+    out[i] = table.colors[entry];
+  }
 }
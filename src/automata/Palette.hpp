@@ -3,20 +3,43 @@
 
 #include "Grid.hpp"
 #include "imgui/imgui.h"
+#include "utils/CpuFeatures.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// what the isa specific bodies of Palette::colorize see
+struct PaletteTable
+{
+  const Color* colors;
+  uint32_t size;
+  float inverseSize; // 1 / size, so wrapping an index doesn't divide
+};
 
 struct Palette
 {
+  // table entries per step, fine enough that a gradient of a few steps
+  // doesn't show bands
+  static const uint32_t tableResolution = 8;
+
   Palette(std::vector<Color> colors, uint32_t numSteps = 100)
     : m_colors(colors), m_numSteps(numSteps)
   {
+    bakeTable();
   }
 
   Color getColor(double index);
 
+  // the colors of count indices, which wrap around the palette like
+  // getColor. NaN indices are skipped and leave out as it was
+  void colorize(const float* indices, Color* out, uint32_t count,
+                automata::SimdLevel level) const;
+
   void updateColors(std::vector<ImVec4> colors);
   void updateSize(uint32_t numSteps)
   {
     m_numSteps = numSteps;
+    bakeTable();
   }
 
   uint32_t getNumSteps()
@@ -26,5 +49,23 @@ struct Palette
 
   std::vector<Color> m_colors;
   uint32_t m_numSteps;
+
+private:
+  // works out m_table from m_colors and m_numSteps
+  void bakeTable();
+
+  PaletteTable getTable() const
+  {
+    return PaletteTable{m_table.data(), (uint32_t)m_table.size(),
+                        1.0f / m_table.size()};
+  }
+
+  // m_numSteps * tableResolution colors, so coloring a pixel is a lookup
+  std::vector<Color> m_table;
 };
+
+void colorizeScalar(const PaletteTable& table, const float* indices,
+                    Color* out, uint32_t start, uint32_t count);
+void colorizeAvx2(const PaletteTable& table, const float* indices, Color* out,
+                  uint32_t count);
 #endif
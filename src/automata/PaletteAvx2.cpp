@@ -0,0 +1,32 @@
+#include "Palette.hpp"
+
+#ifdef AUTOMATA_X86
+#include <immintrin.h>
+
+void colorizeAvx2(const PaletteTable& table, const float* indices, Color* out,
+                  uint32_t count)
+{
+  const __m256 resolution = _mm256_set1_ps(Palette::tableResolution);
+  const __m256 size = _mm256_set1_ps(table.size);
+  const __m256 inverseSize = _mm256_set1_ps(table.inverseSize);
+  const __m256i last = _mm256_set1_epi32(table.size - 1);
+  const __m256i zero = _mm256_setzero_si256();
+  const int* colors = (const int*)table.colors;
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 index = _mm256_loadu_ps(indices + i);
+    __m256 position = _mm256_mul_ps(index, resolution);
+    __m256 wraps = _mm256_floor_ps(_mm256_mul_ps(position, inverseSize));
+    position = _mm256_sub_ps(position, _mm256_mul_ps(wraps, size));
+    // NaN converts to INT_MIN, which the clamp turns into a safe entry
+    __m256i entry = _mm256_cvttps_epi32(position);
+    entry = _mm256_min_epi32(_mm256_max_epi32(entry, zero), last);
+    __m256i color = _mm256_i32gather_epi32(colors, entry, 4);
+    __m256i known =
+      _mm256_castps_si256(_mm256_cmp_ps(index, index, _CMP_ORD_Q));
+    _mm256_maskstore_epi32((int*)(out + i), known, color);
+  }
+  colorizeScalar(table, indices, out, i, count);
+}
+#endif
@@ -0,0 +1,199 @@
+#include "Perturbation.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace fractal
+{
+ReferenceOrbit getReferenceOrbit(const automata::BigFixed& c_x,
+                                 const automata::BigFixed& c_y,
+                                 uint32_t maxIterations,
+                                 const std::function<bool()>& isCancelled)
+{
+  ReferenceOrbit orbit{};
+  orbit.x.reserve(maxIterations + 1);
+  orbit.y.reserve(maxIterations + 1);
+
+  uint32_t limbs = std::max(c_x.getFractionLimbs(), c_y.getFractionLimbs());
+  automata::BigFixed z_x(0, limbs);
+  automata::BigFixed z_y(0, limbs);
+  orbit.x.push_back(0);
+  orbit.y.push_back(0);
+  for (uint32_t i = 0; i < maxIterations; i++)
+  {
+    if (i % cancelCheckIterations == 0 && isCancelled && isCancelled())
+      break;
+    automata::BigFixed x_2 = z_x * z_x;
+    automata::BigFixed y_2 = z_y * z_y;
+    automata::BigFixed xy = z_x * z_y;
+    z_y = xy + xy + c_y;
+    z_x = x_2 - y_2 + c_x;
+
+    double x = z_x.toDouble();
+    double y = z_y.toDouble();
+    orbit.x.push_back(x);
+    orbit.y.push_back(y);
+    // past the largest bailout, points going further along would have
+    // escaped already
+    if (x * x + y * y > 16)
+      break;
+  }
+  return orbit;
+}
+
+void approximateSeries(ReferenceOrbit& orbit, double radius, double pixelSize,
+                       const std::function<bool()>& isCancelled)
+{
+  // a, b and c of z_n = Z_n + d_n start at 0, and from d_n+1 = 2 Z_n d_n +
+  // d_n^2 + dc, a goes to 2Za + 1, b to 2Zb + a^2 and c to 2Zc + 2ab
+  double a_x = 0, a_y = 0;
+  double b_x = 0, b_y = 0;
+  double c_x = 0, c_y = 0;
+  orbit.skipped = 0;
+  double radius_3 = radius * radius * radius;
+  // stop one short of the end, so every point still has a step to take
+  for (uint32_t n = 0; n + 2 < orbit.x.size(); n++)
+  {
+    if (n % cancelCheckIterations == 0 && isCancelled && isCancelled())
+      break;
+    double Z_x = orbit.x[n];
+    double Z_y = orbit.y[n];
+    double a_x_new = 2 * (Z_x * a_x - Z_y * a_y) + 1;
+    double a_y_new = 2 * (Z_x * a_y + Z_y * a_x);
+    double b_x_new = 2 * (Z_x * b_x - Z_y * b_y) + a_x * a_x - a_y * a_y;
+    double b_y_new = 2 * (Z_x * b_y + Z_y * b_x) + 2 * a_x * a_y;
+    double c_x_new =
+      2 * (Z_x * c_x - Z_y * c_y) + 2 * (a_x * b_x - a_y * b_y);
+    double c_y_new = 2 * (Z_x * c_y + Z_y * c_x) + 2 * (a_x * b_y + a_y * b_x);
+
+    // the terms left out are about as big as the last one kept. Divided by
+    // a they are an error in dc, which has to stay well inside a pixel
+    double a = sqrt(a_x_new * a_x_new + a_y_new * a_y_new);
+    double c = sqrt(c_x_new * c_x_new + c_y_new * c_y_new);
+    if (!(c * radius_3 < 1e-5 * pixelSize * a))
+      break;
+
+    a_x = a_x_new, a_y = a_y_new;
+    b_x = b_x_new, b_y = b_y_new;
+    c_x = c_x_new, c_y = c_y_new;
+    orbit.skipped = n + 1;
+  }
+  orbit.seriesX[0] = a_x, orbit.seriesY[0] = a_y;
+  orbit.seriesX[1] = b_x, orbit.seriesY[1] = b_y;
+  orbit.seriesX[2] = c_x, orbit.seriesY[2] = c_y;
+}
+
+void iteratePerturbed(const SpanArgs& args, Escape* out)
+{
+  const std::vector<double>& ref_x = args.reference->x;
+  const std::vector<double>& ref_y = args.reference->y;
+  uint32_t last = ref_x.size() - 1;
+  double bailout = args.smooth == Smooth::Logarithmic ? 16 : 4;
+  double attracted = getAttractedDerivative(args.pixelSize);
+  // distance estimates need the derivative along the whole orbit
+  uint32_t skipped =
+    args.smooth == Smooth::Distance ? 0 : args.reference->skipped;
+  skipped = std::min(skipped, args.maxIterations);
+  const double* s_x = args.reference->seriesX;
+  const double* s_y = args.reference->seriesY;
+  uint64_t iterated = 0;
+  for (uint32_t i = 0; i < args.count; i++)
+  {
+    double dc_x = args.x[i];
+    double dc_y = getPointY(args, i);
+
+    // offset from the reference, and where along the reference we are.
+    // a dc + b dc^2 + c dc^3 is (((c dc) + b) dc + a) dc
+    double d_x = 0;
+    double d_y = 0;
+    if (skipped)
+    {
+      for (int32_t term = 2; term >= 0; term--)
+      {
+        double t_x = (d_x + s_x[term]) * dc_x - (d_y + s_y[term]) * dc_y;
+        double t_y = (d_x + s_x[term]) * dc_y + (d_y + s_y[term]) * dc_x;
+        d_x = t_x;
+        d_y = t_y;
+      }
+    }
+    uint32_t n = skipped;
+
+    double z_x = args.reference->x[n] + d_x;
+    double z_y = args.reference->y[n] + d_y;
+
+    double before_x = 0;
+    double before_y = 0;
+
+    double x_2 = z_x * z_x;
+    double y_2 = z_y * z_y;
+
+    double dz_x = 1;
+    double dz_y = 0;
+
+    double dzz_2 = 1;
+    bool early = false;
+
+    uint32_t iteration = skipped;
+
+    while (x_2 + y_2 < bailout && iteration < args.maxIterations)
+    {
+      before_x = z_x;
+      before_y = z_y;
+
+      // z = Z + d, so d goes to 2Zd + d^2 + dc while Z goes along the
+      // reference
+      double Z_x = ref_x[n];
+      double Z_y = ref_y[n];
+      double d_x_new =
+        2 * (Z_x * d_x - Z_y * d_y) + d_x * d_x - d_y * d_y + dc_x;
+      d_y = 2 * (Z_x * d_y + Z_y * d_x) + 2 * d_x * d_y + dc_y;
+      d_x = d_x_new;
+      n++;
+
+      z_x = ref_x[n] + d_x;
+      z_y = ref_y[n] + d_y;
+      x_2 = z_x * z_x;
+      y_2 = z_y * z_y;
+
+      if (args.smooth == Smooth::Distance)
+      {
+        double dz_x_new = 2 * (z_x * dz_x - z_y * dz_y) + 1;
+        double dz_y_new = 2 * (z_y * dz_x + z_x * dz_y);
+        dz_x = dz_x_new;
+        dz_y = dz_y_new;
+      }
+
+      iteration++;
+
+      // the glitch check, and running off the end of an escaped reference.
+      // z_0 of the reference is 0, so the whole point becomes the offset
+      if (x_2 + y_2 < d_x * d_x + d_y * d_y || n == last)
+      {
+        d_x = z_x;
+        d_y = z_y;
+        n = 0;
+      }
+
+      // only the derivative check, points just outside a minibrot follow
+      // its cycle far closer than periodEpsilon
+      if (args.interiorChecks)
+      {
+        dzz_2 *= 4 * (x_2 + y_2);
+        if (dzz_2 < attracted * attracted)
+        {
+          iterated += iteration - skipped;
+          early = true;
+          iteration = args.maxIterations;
+          break;
+        }
+      }
+    }
+    if (!early)
+      iterated += iteration - skipped;
+    out[i] =
+      Escape{iteration, x_2, y_2, before_x, before_y, dz_x, dz_y, early};
+  }
+  if (args.iterated)
+    *args.iterated += iterated;
+}
+} // namespace fractal
@@ -0,0 +1,53 @@
+#ifndef AUTOMATA_PERTURBATION
+#define AUTOMATA_PERTURBATION
+
+#include "FractalKernel.hpp"
+#include "utils/Numeric.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace fractal
+{
+// the mandelbrot orbit of one point worked out in full precision and
+// rounded to doubles. Every other pixel of a deep zoom only iterates its
+// small offset from this orbit, which doubles can hold
+struct ReferenceOrbit
+{
+  std::vector<double> x; // z_0 = 0 to where it escaped or maxIterations
+  std::vector<double> y;
+
+  // the offset of a point dc from the reference after skipped iterations is
+  // about a dc + b dc^2 + c dc^3, so points can start there. Indexed by
+  // [a, b, c], 0 skipped until approximateSeries
+  uint32_t skipped;
+  double seriesX[3];
+  double seriesY[3];
+};
+
+// isCancelled is checked every cancelCheckIterations and may be empty. A
+// cancelled orbit stops short
+ReferenceOrbit getReferenceOrbit(const automata::BigFixed& c_x,
+                                 const automata::BigFixed& c_y,
+                                 uint32_t maxIterations,
+                                 const std::function<bool()>& isCancelled = {});
+
+// works out the series of the orbit for offsets up to radius, and skips as
+// many iterations as it can before the terms it leaves out could move a point
+// by 1e-5 of pixelSize. Chaotic points magnify anything bigger. A cancelled
+// series skips what it had got to
+void approximateSeries(ReferenceOrbit& orbit, double radius, double pixelSize,
+                       const std::function<bool()>& isCancelled = {});
+
+// iterations of the orbit and the series between checks of isCancelled
+const uint32_t cancelCheckIterations = 1024;
+
+// iterates points given as offsets from args.reference. Once an offset
+// grows past the point itself the difference from the reference can no
+// longer be trusted, so the point carries on from the start of the reference
+// with its whole value as the offset
+void iteratePerturbed(const SpanArgs& args, Escape* out);
+} // namespace fractal
+
+#endif
@@ -0,0 +1,23 @@
+#include "Presenter.hpp"
+
+#include "utils/Profiler.hpp"
+
+void SoftwarePresenter::publish(Grid& grid)
+{
+  automata::ProfileZone zone("SoftwarePresenter::publish");
+  if (m_grid.getWidth() != grid.getWidth() ||
+      m_grid.getHeight() != grid.getHeight())
+    m_grid = Grid(grid.getWidth(), grid.getHeight());
+  std::memcpy(m_grid.getData(), grid.getData(),
+              grid.getWidth() * grid.getHeight() * 4);
+}
+
+void SoftwarePresenter::present(uint32_t scale)
+{
+  automata::ProfileZone zone("SoftwarePresenter::present");
+  uint64_t width = m_grid.getWidth() * scale;
+  uint64_t height = m_grid.getHeight() * scale;
+  if (m_image.getWidth() != width || m_image.getHeight() != height)
+    m_image = Grid(width, height);
+  upsampleGrid(m_grid, m_image, scale);
+}
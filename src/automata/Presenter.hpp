@@ -0,0 +1,46 @@
+#ifndef AUTOMATA_PRESENTER
+#define AUTOMATA_PRESENTER
+
+#include "Grid.hpp"
+
+// shows the grid of an automaton. The automaton publishes it at a pixel per
+// cell and the presenter scales it up point sampled as it draws, so nothing
+// keeps a scale x scale copy of the grid
+class Presenter
+{
+public:
+  virtual ~Presenter()
+  {
+  }
+
+  // a new generation, takes what it needs of grid to draw it later
+  virtual void publish(Grid& grid) = 0;
+
+  // the last grid published, every cell a scale x scale block
+  virtual void present(uint32_t scale) = 0;
+};
+
+// draws into an image in memory, for running without a window
+class SoftwarePresenter : public Presenter
+{
+public:
+  SoftwarePresenter() : m_grid(0, 0), m_image(0, 0)
+  {
+  }
+
+  void publish(Grid& grid) override;
+
+  void present(uint32_t scale) override;
+
+  // what the last present drew
+  Grid& getImage()
+  {
+    return m_image;
+  }
+
+private:
+  Grid m_grid; // as it was published
+  Grid m_image;
+};
+
+#endif
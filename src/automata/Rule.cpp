@@ -0,0 +1,209 @@
+#include "Rule.hpp"
+
+#include <bitset>
+#include <cctype>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// one configuration of every isotropic class of 1 to 4 neighbors, rows top to
+// bottom with the centre cell in the middle. 5 to 7 neighbors take the letter
+// of their dead cells
+struct HenselClass
+{
+  uint32_t count;
+  char letter;
+  const char* cells;
+};
+
+const HenselClass henselClasses[] = {
+  {1, 'c', "x.." "..." "..."}, {1, 'e', ".x." "..." "..."},
+  {2, 'c', "x.x" "..." "..."}, {2, 'e', ".x." "x.." "..."},
+  {2, 'k', "x.." "..x" "..."}, {2, 'a', "xx." "..." "..."},
+  {2, 'i', "..." "x.x" "..."}, {2, 'n', "..x" "..." "x.."},
+  {3, 'c', "x.x" "..." "x.."}, {3, 'e', ".x." "x.x" "..."},
+  {3, 'k', ".x." "..x" "x.."}, {3, 'a', "xx." "x.." "..."},
+  {3, 'i', "xxx" "..." "..."}, {3, 'n', "x.x" "x.." "..."},
+  {3, 'y', "x.." "..x" "x.."}, {3, 'q', ".xx" "..." "x.."},
+  {3, 'j', ".xx" "x.." "..."}, {3, 'r', "x.." "x.x" "..."},
+  {4, 'c', "x.x" "..." "x.x"}, {4, 'e', ".x." "x.x" ".x."},
+  {4, 'k', "xx." "..x" "x.."}, {4, 'a', "xxx" "x.." "..."},
+  {4, 'i', "x.x" "x.x" "..."}, {4, 'n', "xxx" "..." "x.."},
+  {4, 'y', "x.x" "..." ".xx"}, {4, 'q', ".xx" "..x" "x.."},
+  {4, 'j', ".x." "x.x" "x.."}, {4, 'r', "xx." "x.x" "..."},
+  {4, 't', "xxx" "..." ".x."}, {4, 'w', "x.." "x.." ".xx"},
+  {4, 'z', "xx." "..." ".xx"},
+};
+
+const uint32_t centreBit = 1 << 4;
+
+// the letters of a neighbor count in Hensel's order
+const char* getLetters(uint32_t count)
+{
+  const char* letters[] = {"", "ce", "cekain", "cekainyqjr", "cekainyqjrtwz"};
+  if (count > 8)
+    return "";
+  return letters[count <= 4 ? count : 8 - count];
+}
+
+// the Hensel letter of every 3x3 pattern, 0 for 0 and 8 neighbors
+const std::vector<char>& getLetterTable()
+{
+  static std::vector<char> table = [] {
+    std::vector<char> letters(512, 0);
+    for (const HenselClass& henselClass : henselClasses)
+    {
+      // all eight rotations and reflections of the configuration
+      for (uint32_t symmetry = 0; symmetry < 8; symmetry++)
+      {
+        uint32_t pattern = 0;
+        for (int32_t i = 0; i < 9; i++)
+        {
+          if (henselClass.cells[i] != 'x')
+            continue;
+          int32_t dy = i / 3 - 1;
+          int32_t dx = i % 3 - 1;
+          for (uint32_t turn = 0; turn < symmetry % 4; turn++)
+          {
+            std::swap(dy, dx);
+            dx = -dx;
+          }
+          if (symmetry >= 4)
+            dx = -dx;
+          pattern |= 1 << Rule::getPatternBit(dy, dx);
+        }
+        uint32_t inverse = pattern ^ 0x1ff ^ centreBit;
+        for (uint32_t centre : {0u, centreBit})
+        {
+          letters[pattern | centre] = henselClass.letter;
+          // four neighbors have their own letters for both halves
+          if (henselClass.count < 4)
+            letters[inverse | centre] = henselClass.letter;
+        }
+      }
+    }
+    return letters;
+  }();
+  return table;
+}
+
+bool parseConditions(const std::string& text, std::set<uint8_t>& counts,
+                     std::set<std::string>& isotropic)
+{
+  size_t i = 0;
+  while (i < text.size())
+  {
+    if (text[i] < '0' || text[i] > '8')
+      return false;
+    uint32_t count = text[i++] - '0';
+    bool exclude = i < text.size() && text[i] == '-';
+    if (exclude)
+      i++;
+    std::string letters;
+    while (i < text.size() && std::isalpha((unsigned char)text[i]))
+      letters += (char)std::tolower((unsigned char)text[i++]);
+
+    if (letters.empty())
+    {
+      if (exclude)
+        return false;
+      counts.insert(count);
+      continue;
+    }
+    const char* valid = getLetters(count);
+    for (char letter : letters)
+      if (!std::strchr(valid, letter))
+        return false;
+    for (const char* letter = valid; *letter; letter++)
+      if ((letters.find(*letter) != std::string::npos) != exclude)
+        isotropic.insert(std::to_string(count) + *letter);
+  }
+  return true;
+}
+
+std::string conditionsToString(const std::set<uint8_t>& counts,
+                               const std::set<std::string>& isotropic)
+{
+  std::string text;
+  for (uint32_t count = 0; count < 256; count++)
+  {
+    if (counts.count(count))
+    {
+      text += std::to_string(count);
+      continue;
+    }
+    // whichever of the letters or the letters left out is shorter
+    std::string letters;
+    std::string missing = "-";
+    for (const char* letter = getLetters(count); *letter; letter++)
+    {
+      if (isotropic.count(std::to_string(count) + *letter))
+        letters += *letter;
+      else
+        missing += *letter;
+    }
+    if (!letters.empty())
+      text += std::to_string(count) +
+              (missing.size() <= letters.size() ? missing : letters);
+  }
+  return text;
+}
+} // namespace
+
+void Rule::compile()
+{
+  for (uint32_t n = 0; n < 256; n++)
+  {
+    m_transitions[0][n] = m_birthConditions.count(n) ? 1 : 0;
+    m_transitions[1][n] = m_surviveConditions.count(n) ? 1 : 0;
+  }
+
+  const std::vector<char>& letters = getLetterTable();
+  for (uint32_t pattern = 0; pattern < 512; pattern++)
+  {
+    uint32_t alive = (pattern & centreBit) ? 1 : 0;
+    uint32_t count = std::bitset<9>(pattern & ~centreBit).count();
+    uint8_t next = m_transitions[alive][count];
+    if (!next && letters[pattern])
+    {
+      const std::set<std::string>& isotropic =
+        alive ? m_surviveIsotropic : m_birthIsotropic;
+      next = isotropic.count(std::to_string(count) + letters[pattern]);
+    }
+    m_moore[pattern] = next;
+  }
+}
+
+bool Rule::parse(const std::string& text)
+{
+  size_t slash = text.find('/');
+  if (slash == std::string::npos)
+    return false;
+  std::string parts[2] = {text.substr(0, slash), text.substr(slash + 1)};
+  std::set<uint8_t> counts[2];
+  std::set<std::string> isotropic[2];
+  const char prefixes[2] = {'b', 's'};
+  for (uint32_t i = 0; i < 2; i++)
+  {
+    if (parts[i].empty() ||
+        std::tolower((unsigned char)parts[i][0]) != prefixes[i])
+      return false;
+    if (!parseConditions(parts[i].substr(1), counts[i], isotropic[i]))
+      return false;
+  }
+
+  m_birthConditions = counts[0];
+  m_surviveConditions = counts[1];
+  m_birthIsotropic = isotropic[0];
+  m_surviveIsotropic = isotropic[1];
+  compile();
+  return true;
+}
+
+std::string Rule::toString() const
+{
+  return "B" + conditionsToString(m_birthConditions, m_birthIsotropic) +
+         "/S" + conditionsToString(m_surviveConditions, m_surviveIsotropic);
+}
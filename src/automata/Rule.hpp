@@ -0,0 +1,77 @@
+#ifndef AUTOMATA_RULE
+#define AUTOMATA_RULE
+
+#include <cstdint>
+#include <set>
+#include <string>
+
+struct Rule
+{
+  Rule(const std::set<uint8_t>& birthConditions,
+       const std::set<uint8_t>& surviveConditions)
+    : m_birthConditions(birthConditions), m_surviveConditions(surviveConditions)
+  {
+    compile();
+  }
+
+  // rebuilds the lookup tables, call after editing any of the conditions
+  void compile();
+
+  bool survived(uint8_t neighbors)
+  {
+    return m_transitions[1][neighbors];
+  }
+
+  bool born(uint8_t neighbors)
+  {
+    return m_transitions[0][neighbors];
+  }
+
+  // next state of a Moore distance 1 cell from its 3x3 block, built from
+  // getPatternBit
+  bool next(uint32_t pattern)
+  {
+    return m_moore[pattern];
+  }
+
+  // columns are three bits each, right column lowest, so a pattern slides one
+  // cell to the right with ((pattern << 3) | column) & 0x1ff. the centre is
+  // bit 4
+  static uint32_t getPatternBit(int32_t dy, int32_t dx)
+  {
+    return 3 * (1 - dx) + (dy + 1);
+  }
+
+  bool isTotalistic() const
+  {
+    return m_birthIsotropic.empty() && m_surviveIsotropic.empty();
+  }
+
+  // B/S rules in Hensel notation such as "B3/S23" or "B2-a/S12". returns
+  // false and leaves the rule alone if the text doesn't parse
+  bool parse(const std::string& text);
+
+  std::string toString() const;
+
+  bool operator!=(const Rule& other) const
+  {
+    return m_birthConditions != other.m_birthConditions ||
+           m_surviveConditions != other.m_surviveConditions ||
+           m_birthIsotropic != other.m_birthIsotropic ||
+           m_surviveIsotropic != other.m_surviveIsotropic;
+  }
+
+  std::set<uint8_t> m_birthConditions;
+  std::set<uint8_t> m_surviveConditions;
+  // single isotropic configurations on top of the counts, a neighbor count
+  // followed by its Hensel letter like "2a". only Moore distance 1 rules
+  // can see them
+  std::set<std::string> m_birthIsotropic;
+  std::set<std::string> m_surviveIsotropic;
+
+  // indexed by [alive][neighbor count] and by 3x3 pattern
+  uint8_t m_transitions[2][256];
+  uint8_t m_moore[512];
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "TexturePresenter.hpp"
+
+#include "imgui/imgui.h"
+#include "utils/LoadTextureFromData.hpp"
+#include "utils/Profiler.hpp"
+
+#include <d3d11.h>
+
+namespace
+{
+// an ImGui draw callback, the draws after it sample with
+// cmd->UserCallbackData until the render state is reset
+void usePointSampler(const ImDrawList*, const ImDrawCmd* cmd)
+{
+  ID3D11SamplerState* sampler = (ID3D11SamplerState*)cmd->UserCallbackData;
+  ID3D11Device* device = NULL;
+  ID3D11DeviceContext* context = NULL;
+  sampler->GetDevice(&device);
+  device->GetImmediateContext(&context);
+  context->PSSetSamplers(0, 1, &sampler);
+  context->Release();
+  device->Release();
+}
+} // namespace
+
+TexturePresenter::TexturePresenter(ID3D11Device* pDevice)
+  : m_pDevice(pDevice),
+    m_texture(NULL),
+    m_view(NULL),
+    m_sampler(NULL),
+    m_width(0),
+    m_height(0)
+{
+  D3D11_SAMPLER_DESC desc;
+  ZeroMemory(&desc, sizeof(desc));
+  desc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
+  desc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+  desc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+  desc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+  desc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+  m_pDevice->CreateSamplerState(&desc, &m_sampler);
+}
+
+TexturePresenter::~TexturePresenter()
+{
+  if (m_view)
+    m_view->Release();
+  if (m_texture)
+    m_texture->Release();
+  if (m_sampler)
+    m_sampler->Release();
+}
+
+void TexturePresenter::publish(Grid& grid)
+{
+  automata::ProfileZone zone("TexturePresenter::publish");
+  uint64_t width = grid.getWidth();
+  uint64_t height = grid.getHeight();
+  if (m_texture && width == m_width && height == m_height)
+  {
+    // the texture is dynamic, a new generation is written over the old one
+    ID3D11DeviceContext* context = NULL;
+    m_pDevice->GetImmediateContext(&context);
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (SUCCEEDED(
+          context->Map(m_texture, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+    {
+      for (uint64_t row = 0; row < height; row++)
+        std::memcpy((uint8_t*)mapped.pData + row * mapped.RowPitch,
+                    grid.getData() + row * width * 4, width * 4);
+      context->Unmap(m_texture, 0);
+    }
+    context->Release();
+    return;
+  }
+
+  if (m_view)
+    m_view->Release();
+  if (m_texture)
+    m_texture->Release();
+  automata::LoadTextureFromData(grid.getData(), &m_view, &m_texture,
+                                m_pDevice, width, height);
+  m_width = width;
+  m_height = height;
+}
+
+void TexturePresenter::present(uint32_t scale)
+{
+  ImVec2 size(m_width * scale, m_height * scale);
+  if (!m_view || !m_sampler)
+  {
+    ImGui::Dummy(size);
+    return;
+  }
+  ImDrawList* drawList = ImGui::GetWindowDrawList();
+  drawList->AddCallback(usePointSampler, m_sampler);
+  ImGui::Image((void*)m_view, size);
+  drawList->AddCallback(ImDrawCallback_ResetRenderState, NULL);
+}
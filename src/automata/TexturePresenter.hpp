@@ -0,0 +1,33 @@
+#ifndef AUTOMATA_TEXTURE_PRESENTER
+#define AUTOMATA_TEXTURE_PRESENTER
+
+#include "Presenter.hpp"
+#include "utils/D3D11Forward.hpp"
+
+// uploads the grid to a texture at a texel per cell and draws it as an
+// ImGui image, with a point sampler so the cells keep their hard edges
+class TexturePresenter : public Presenter
+{
+public:
+  explicit TexturePresenter(ID3D11Device* pDevice);
+
+  ~TexturePresenter();
+
+  TexturePresenter(const TexturePresenter&) = delete;
+  TexturePresenter& operator=(const TexturePresenter&) = delete;
+
+  void publish(Grid& grid) override;
+
+  // an ImGui item of the scaled size, so the caller can ask if it's hovered
+  void present(uint32_t scale) override;
+
+private:
+  ID3D11Device* m_pDevice;
+  ID3D11Texture2D* m_texture;
+  ID3D11ShaderResourceView* m_view;
+  ID3D11SamplerState* m_sampler;
+  uint64_t m_width;
+  uint64_t m_height;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "TileActivity.hpp"
+
+#include <algorithm>
+
+TileActivity::TileActivity(uint64_t width, uint64_t height, uint64_t tileSize,
+                           int64_t reach)
+  : m_width(width),
+    m_height(height),
+    m_tileSize(tileSize),
+    m_reach(reach),
+    m_tilesX((width + tileSize - 1) / tileSize),
+    m_tilesY((height + tileSize - 1) / tileSize),
+    m_changed(m_tilesX * m_tilesY, 1),
+    m_active(m_tilesX * m_tilesY, 1),
+    m_activeFraction(1)
+{
+}
+
+void TileActivity::markAllChanged()
+{
+  std::fill(m_changed.begin(), m_changed.end(), 1);
+}
+
+std::vector<std::vector<uint64_t>>
+TileActivity::getNearbyTiles(uint64_t cells, uint64_t tiles, bool wrap)
+{
+  std::vector<std::vector<uint64_t>> nearby(tiles);
+  int64_t numCells = cells;
+  for (uint64_t tile = 0; tile < tiles; tile++)
+  {
+    int64_t first = tile * m_tileSize;
+    int64_t last = std::min<int64_t>(first + m_tileSize, numCells) - 1;
+    // walking every cell in reach also covers tiles narrower than the reach
+    for (int64_t cell = first - m_reach; cell <= last + m_reach; cell++)
+    {
+      int64_t c = cell;
+      if (wrap)
+        c = ((c % numCells) + numCells) % numCells;
+      else if (c < 0 || c >= numCells)
+        continue;
+      uint64_t t = c / m_tileSize;
+      if (std::find(nearby[tile].begin(), nearby[tile].end(), t) ==
+          nearby[tile].end())
+        nearby[tile].push_back(t);
+    }
+  }
+  return nearby;
+}
+
+void TileActivity::updateActive(bool wrap)
+{
+  auto nearbyX = getNearbyTiles(m_width, m_tilesX, wrap);
+  auto nearbyY = getNearbyTiles(m_height, m_tilesY, wrap);
+
+  uint64_t numActive = 0;
+  for (uint64_t ty = 0; ty < m_tilesY; ty++)
+  {
+    for (uint64_t tx = 0; tx < m_tilesX; tx++)
+    {
+      uint8_t active = 0;
+      for (uint64_t ny : nearbyY[ty])
+        for (uint64_t nx : nearbyX[tx])
+          active |= m_changed[ny * m_tilesX + nx];
+      m_active[ty * m_tilesX + tx] = active;
+      numActive += active;
+    }
+  }
+  m_activeFraction =
+    m_active.empty() ? 0.0 : (double)numActive / m_active.size();
+  std::fill(m_changed.begin(), m_changed.end(), 0);
+}
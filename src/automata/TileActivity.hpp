@@ -0,0 +1,69 @@
+#ifndef AUTOMATA_TILE_ACTIVITY
+#define AUTOMATA_TILE_ACTIVITY
+
+#include <cstdint>
+#include <vector>
+
+// which square tiles of a grid changed last generation, and from that which
+// tiles can change in the next one. A tile is active when a tile holding a
+// cell within 'reach' of it changed, every other tile is stable and can be
+// skipped
+class TileActivity
+{
+public:
+  TileActivity(uint64_t width, uint64_t height, uint64_t tileSize,
+               int64_t reach);
+
+  // after edits from outside, every tile has to be recomputed once
+  void markAllChanged();
+
+  void markChanged(uint64_t tileX, uint64_t tileY)
+  {
+    m_changed[tileY * m_tilesX + tileX] = 1;
+  }
+
+  // turns last generation's changes into this generation's active tiles and
+  // starts a fresh set of changes
+  void updateActive(bool wrap);
+
+  bool isActive(uint64_t tileX, uint64_t tileY)
+  {
+    return m_active[tileY * m_tilesX + tileX];
+  }
+
+  // share of the tiles the last updateActive found active, 0 to 1
+  double getActiveFraction()
+  {
+    return m_activeFraction;
+  }
+
+  uint64_t getTileSize()
+  {
+    return m_tileSize;
+  }
+  uint64_t getTilesX()
+  {
+    return m_tilesX;
+  }
+  uint64_t getTilesY()
+  {
+    return m_tilesY;
+  }
+
+private:
+  // the tiles along one axis whose cells are within reach of each tile
+  std::vector<std::vector<uint64_t>> getNearbyTiles(uint64_t cells,
+                                                    uint64_t tiles, bool wrap);
+
+  uint64_t m_width;
+  uint64_t m_height;
+  uint64_t m_tileSize;
+  int64_t m_reach;
+  uint64_t m_tilesX;
+  uint64_t m_tilesY;
+  std::vector<uint8_t> m_changed;
+  std::vector<uint8_t> m_active;
+  double m_activeFraction;
+};
+
+#endif
@@ -0,0 +1,366 @@
+#include "TileCache.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+using fractal::TileKey;
+
+const uint32_t recordMagic = 0x32435446; // "FTC2"
+const uint32_t runBit = 0x80000000;
+const uint64_t headerBytes = 48; // magic, key and word count
+
+template <typename T>
+void writeValue(std::ostream& out, const T& value)
+{
+  out.write((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::istream& in, T& value)
+{
+  return (bool)in.read((char*)&value, sizeof(T));
+}
+
+void writeKey(std::ostream& out, const TileKey& key)
+{
+  writeValue(out, (uint8_t)key.type);
+  writeValue(out, (uint8_t)key.smooth);
+  writeValue(out, key.maxIterations);
+  writeValue(out, key.seedX);
+  writeValue(out, key.seedY);
+  writeValue(out, key.minDistance);
+  writeValue(out, (uint8_t)key.interiorChecks);
+  writeValue(out, (uint8_t)key.subdivide);
+  writeValue(out, key.zoom);
+  writeValue(out, key.x);
+  writeValue(out, key.y);
+}
+
+bool readKey(std::istream& in, TileKey& key)
+{
+  uint8_t type;
+  uint8_t smooth;
+  uint8_t interiorChecks;
+  uint8_t subdivide;
+  bool read = readValue(in, type) && readValue(in, smooth) &&
+              readValue(in, key.maxIterations) && readValue(in, key.seedX) &&
+              readValue(in, key.seedY) && readValue(in, key.minDistance) &&
+              readValue(in, interiorChecks) && readValue(in, subdivide) &&
+              readValue(in, key.zoom) && readValue(in, key.x) &&
+              readValue(in, key.y);
+  key.type = (FractalType)type;
+  key.smooth = (Smooth)smooth;
+  key.interiorChecks = interiorChecks;
+  key.subdivide = subdivide;
+  return read;
+}
+
+// packets of 32 bit words. A header with runBit set is followed by one word
+// repeated that many times, otherwise by that many words as they are. Runs
+// are the set and bands of equal iterations, smooth values mostly go as
+// they are
+std::vector<uint32_t> encode(const std::vector<float>& values)
+{
+  std::vector<uint32_t> words(values.size());
+  std::memcpy(words.data(), values.data(), values.size() * 4);
+  std::vector<uint32_t> packets;
+  uint32_t literals = 0; // where the open literal packet starts
+  auto closeLiterals = [&](uint32_t end) {
+    if (end > literals)
+    {
+      packets.push_back(end - literals);
+      packets.insert(packets.end(), words.begin() + literals,
+                     words.begin() + end);
+    }
+  };
+  uint32_t i = 0;
+  while (i < words.size())
+  {
+    uint32_t run = 1;
+    while (i + run < words.size() && words[i + run] == words[i])
+      run++;
+    if (run < 3)
+    {
+      i += run;
+      continue;
+    }
+    closeLiterals(i);
+    packets.push_back(runBit | run);
+    packets.push_back(words[i]);
+    i += run;
+    literals = i;
+  }
+  closeLiterals(i);
+  return packets;
+}
+
+bool decode(const std::vector<uint32_t>& packets, std::vector<float>& values)
+{
+  std::vector<uint32_t> words;
+  words.reserve(values.size());
+  for (size_t i = 0; i < packets.size();)
+  {
+    uint32_t count = packets[i] & ~runBit;
+    if (packets[i] & runBit)
+    {
+      if (i + 1 >= packets.size())
+        return false;
+      words.insert(words.end(), count, packets[i + 1]);
+      i += 2;
+    }
+    else
+    {
+      if (i + 1 + count > packets.size())
+        return false;
+      words.insert(words.end(), packets.begin() + i + 1,
+                   packets.begin() + i + 1 + count);
+      i += 1 + count;
+    }
+  }
+  if (words.size() != values.size())
+    return false;
+  std::memcpy(values.data(), words.data(), words.size() * 4);
+  return true;
+}
+} // namespace
+
+namespace fractal
+{
+bool TileKey::operator==(const TileKey& other) const
+{
+  return type == other.type && smooth == other.smooth &&
+         maxIterations == other.maxIterations && seedX == other.seedX &&
+         seedY == other.seedY && minDistance == other.minDistance &&
+         interiorChecks == other.interiorChecks &&
+         subdivide == other.subdivide && zoom == other.zoom && x == other.x &&
+         y == other.y;
+}
+
+size_t TileKeyHash::operator()(const TileKey& key) const
+{
+  size_t hash = std::hash<int64_t>()(key.x);
+  auto combine = [&](size_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+  };
+  combine(std::hash<int64_t>()(key.y));
+  combine(std::hash<int32_t>()(key.zoom));
+  combine(std::hash<int32_t>()(key.maxIterations));
+  combine(std::hash<float>()(key.seedX));
+  combine(std::hash<float>()(key.seedY));
+  combine(std::hash<float>()(key.minDistance));
+  combine((size_t)key.type * 16 + (size_t)key.smooth * 4 +
+          key.interiorChecks * 2 + key.subdivide);
+  return hash;
+}
+
+TileCache::TileCache(const std::string& path, uint64_t memoryBudget,
+                     uint64_t diskBudget)
+  : m_path(path),
+    m_fileSize(0),
+    m_memoryBudget(memoryBudget),
+    m_diskBudget(diskBudget),
+    m_stats{}
+{
+  // in | out doesn't create the file
+  m_file.open(m_path, std::ios::in | std::ios::out | std::ios::binary);
+  if (!m_file.is_open())
+    clearFile();
+  else
+    readIndex();
+}
+
+TileCache::~TileCache()
+{
+  for (const Entry& entry : m_entries)
+    if (!entry.spilled)
+      spill(entry);
+}
+
+bool TileCache::find(const TileKey& key, float* out)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Entry* entry = touch(key);
+  if (entry)
+    m_stats.hits++;
+  else if ((entry = readSpilled(key)))
+    m_stats.diskHits++;
+  else
+  {
+    m_stats.misses++;
+    return false;
+  }
+  std::memcpy(out, entry->values.data(), entry->values.size() * 4);
+  return true;
+}
+
+void TileCache::store(const TileKey& key, const float* values)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Entry* entry = touch(key);
+  if (!entry)
+    entry = readSpilled(key);
+  if (!entry)
+  {
+    insert(key, std::vector<float>(values, values + tileSize * tileSize),
+           false);
+    return;
+  }
+  for (uint32_t i = 0; i < entry->values.size(); i++)
+  {
+    if (std::isnan(entry->values[i]) && !std::isnan(values[i]))
+    {
+      entry->values[i] = values[i];
+      entry->spilled = false;
+    }
+  }
+}
+
+TileCacheStats TileCache::getStats()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  TileCacheStats stats = m_stats;
+  stats.memoryBytes = m_entries.size() * tileSize * tileSize * sizeof(float);
+  stats.diskBytes = m_fileSize;
+  return stats;
+}
+
+TileCache::Entry* TileCache::touch(const TileKey& key)
+{
+  auto found = m_memory.find(key);
+  if (found == m_memory.end())
+    return nullptr;
+  m_entries.splice(m_entries.begin(), m_entries, found->second);
+  return &*found->second;
+}
+
+TileCache::Entry* TileCache::readSpilled(const TileKey& key)
+{
+  auto record = m_disk.find(key);
+  if (record == m_disk.end() || !m_file.is_open())
+    return nullptr;
+  std::vector<uint32_t> packets(record->second.words);
+  std::vector<float> values(tileSize * tileSize);
+  m_file.clear();
+  m_file.seekg(record->second.offset);
+  m_file.read((char*)packets.data(), packets.size() * 4);
+  if (!m_file || !decode(packets, values))
+  {
+    m_disk.erase(record);
+    return nullptr;
+  }
+  return insert(key, std::move(values), true);
+}
+
+TileCache::Entry* TileCache::insert(const TileKey& key,
+                                    std::vector<float> values, bool spilled)
+{
+  m_entries.push_front(Entry{key, std::move(values), spilled});
+  m_memory[key] = m_entries.begin();
+  uint64_t tileBytes = tileSize * tileSize * sizeof(float);
+  while (m_entries.size() > 1 &&
+         m_entries.size() * tileBytes > m_memoryBudget)
+  {
+    const Entry& oldest = m_entries.back();
+    if (!oldest.spilled)
+      spill(oldest);
+    m_memory.erase(oldest.key);
+    m_entries.pop_back();
+  }
+  return &m_entries.front();
+}
+
+void TileCache::spill(const Entry& entry)
+{
+  if (!m_file.is_open())
+    return;
+  std::vector<uint32_t> packets = encode(entry.values);
+  if (m_fileSize + headerBytes + packets.size() * 4 > m_diskBudget)
+    clearFile();
+
+  m_file.clear();
+  m_file.seekp(m_fileSize);
+  writeValue(m_file, recordMagic);
+  writeKey(m_file, entry.key);
+  writeValue(m_file, (uint32_t)packets.size());
+  uint64_t offset = m_file.tellp();
+  m_file.write((const char*)packets.data(), packets.size() * 4);
+  m_file.flush();
+  if (!m_file)
+    return;
+  m_disk[entry.key] = Record{offset, (uint32_t)packets.size()};
+  m_fileSize = m_file.tellp();
+}
+
+void TileCache::readIndex()
+{
+  m_file.seekg(0, std::ios::end);
+  uint64_t end = m_file.tellg();
+  m_file.seekg(0);
+  while (true)
+  {
+    uint32_t magic;
+    TileKey key;
+    uint32_t words;
+    if (!readValue(m_file, magic) || magic != recordMagic ||
+        !readKey(m_file, key) || !readValue(m_file, words))
+      break;
+    // a record cut short by a crash runs past the end
+    uint64_t offset = m_file.tellg();
+    uint64_t recordEnd = offset + (uint64_t)words * 4;
+    if (recordEnd > end)
+      break;
+    m_file.seekg(recordEnd);
+    m_disk[key] = Record{offset, words};
+    m_fileSize = recordEnd;
+  }
+  m_file.clear();
+}
+
+void TileCache::clearFile()
+{
+  m_file.close();
+  m_file.open(m_path, std::ios::in | std::ios::out | std::ios::binary |
+                        std::ios::trunc);
+  m_disk.clear();
+  m_fileSize = 0;
+  // what was read back from the old file is only in memory now
+  for (Entry& entry : m_entries)
+    entry.spilled = false;
+}
+
+bool getTileOrigin(const FractalInfo& f, TileKey& key, int64_t& pixelX,
+                   int64_t& pixelY)
+{
+  if (f.deepZoom.enabled)
+    return false;
+  double pixelWidth = (f.window.xmax - f.window.xmin) / f.imageSize.x;
+  double pixelHeight = (f.window.ymax - f.window.ymin) / f.imageSize.y;
+  if (!(pixelWidth > 0) || std::abs(pixelHeight / pixelWidth - 1) > 1e-6)
+    return false;
+  // pans and zooms leave the corner within rounding of a whole pixel
+  double x = f.window.xmin / pixelWidth;
+  double y = f.window.ymin / pixelWidth;
+  if (std::abs(x) > 1e15 || std::abs(y) > 1e15 ||
+      std::abs(x - std::round(x)) > 1e-3 || std::abs(y - std::round(y)) > 1e-3)
+    return false;
+  pixelX = std::llround(x);
+  pixelY = std::llround(y);
+
+  bool julia = f.type == FractalType::Julia;
+  key = TileKey{f.type,
+                f.smooth,
+                f.maxIterations,
+                julia ? f.seedX : 0,
+                julia ? f.seedY : 0,
+                f.smooth == Smooth::Distance ? f.minDistance : 0,
+                f.interiorChecks,
+                f.subdivide,
+                (int32_t)std::lround(std::log2(pixelWidth) * 256),
+                0,
+                0};
+  return true;
+}
+} // namespace fractal
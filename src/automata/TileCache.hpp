@@ -0,0 +1,120 @@
+#ifndef AUTOMATA_TILE_CACHE
+#define AUTOMATA_TILE_CACHE
+
+#include "Fractal.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fractal
+{
+// where a cached tile is in the plane and what it was rendered with,
+// including the approximations that change its values. Views only pan by
+// whole pixels and zoom by 2 around a pixel, so the tiles of every view line
+// up on one quadtree. zoom is the pixel size as a power of two, and x and y
+// count tiles from the origin
+struct TileKey
+{
+  FractalType type;
+  Smooth smooth;
+  int32_t maxIterations;
+  float seedX; // 0 for the mandelbrot set
+  float seedY;
+  float minDistance; // subdivide fills by it with Smooth::Distance, else 0
+  bool interiorChecks;
+  bool subdivide;
+  int32_t zoom; // log2 of the pixel size, in 1/256ths
+  int64_t x;
+  int64_t y;
+
+  bool operator==(const TileKey& other) const;
+};
+
+struct TileKeyHash
+{
+  size_t operator()(const TileKey& key) const;
+};
+
+// the values of rendered tiles. The most recently used are kept in memory up
+// to a budget, the rest are spilled run length encoded to a file, where later
+// runs of the program find them again
+class TileCache
+{
+public:
+  static const uint32_t tileSize = 64; // pixels per side
+
+  TileCache(const std::string& path, uint64_t memoryBudget,
+            uint64_t diskBudget);
+
+  // spills the tiles only in memory, so the next run finds them
+  ~TileCache();
+
+  // copies the tileSize x tileSize values of key into out, top row first,
+  // NaN where no view has covered them yet. Returns false if the tile isn't
+  // cached
+  bool find(const TileKey& key, float* out);
+
+  // the NaN values fill in from what is cached already
+  void store(const TileKey& key, const float* values);
+
+  TileCacheStats getStats();
+
+private:
+  struct Entry
+  {
+    TileKey key;
+    std::vector<float> values;
+    bool spilled; // the file has these values
+  };
+
+  // where a spilled tile is in the file
+  struct Record
+  {
+    uint64_t offset; // of its packets
+    uint32_t words;
+  };
+
+  // the entry of key to the front of the list, null if it isn't in memory
+  Entry* touch(const TileKey& key);
+
+  // reads a spilled tile back into memory, null if it isn't in the file
+  Entry* readSpilled(const TileKey& key);
+
+  Entry* insert(const TileKey& key, std::vector<float> values, bool spilled);
+
+  void spill(const Entry& entry);
+
+  // indexes the records in the file, and drops whatever follows the last
+  // one that reads back whole
+  void readIndex();
+
+  // starts the file over once it is past its budget, the tiles in memory
+  // are spilled again when they leave it
+  void clearFile();
+
+  std::mutex m_mutex;
+  std::list<Entry> m_entries; // most recently used first
+  std::unordered_map<TileKey, std::list<Entry>::iterator, TileKeyHash>
+    m_memory;
+  std::unordered_map<TileKey, Record, TileKeyHash> m_disk;
+  std::string m_path;
+  std::fstream m_file;
+  uint64_t m_fileSize; // where the next record goes
+  uint64_t m_memoryBudget;
+  uint64_t m_diskBudget;
+  TileCacheStats m_stats;
+};
+
+// the key of f's tiles with x and y left 0, and where the top left pixel of
+// the view is on the quadtree, in pixels. False for views that don't line up
+// with it, like deep zooms
+bool getTileOrigin(const FractalInfo& f, TileKey& key, int64_t& pixelX,
+                   int64_t& pixelY);
+} // namespace fractal
+
+#endif
@@ -0,0 +1,442 @@
+// times the grid primitives and per cell kernels the automata are built from
+// and prints the results as json, one benchmark per line, so two runs can be
+// diffed to spot a regression. See printUsage for the options
+
+#include "automata/Grid.hpp"
+#include "automata/Julia.hpp"
+#include "automata/Mandelbrot.hpp"
+#include "automata/Palette.hpp"
+#include "utils/CpuFeatures.hpp"
+#include "utils/Numeric.hpp"
+#include "utils/Statistics.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+struct Size
+{
+  uint64_t width;
+  uint64_t height;
+};
+
+struct Settings
+{
+  std::vector<Size> sizes;
+  std::vector<uint32_t> scales; // of upsampleGrid
+  std::vector<uint32_t> iterations; // of calculatePixel
+  uint32_t samples;
+  double minSampleMs; // ops are batched until a sample takes this long
+  std::string filter; // only benchmarks with this in their name
+  std::string outPath; // stdout if empty
+};
+
+typedef std::vector<std::pair<std::string, uint64_t>> Params;
+
+struct Result
+{
+  std::string name;
+  Params params;
+  uint64_t itemsPerOp;
+  uint64_t opsPerSample;
+  automata::Summary nsPerItem;
+};
+
+// what the benchmarks add their results into, so the compiler can't drop
+// the work that went into them
+volatile uint64_t sink;
+
+void printUsage()
+{
+  std::fprintf(
+    stderr,
+    "usage: AutomataBench [options]\n"
+    "  --sizes WxH,...        grid sizes (128x128,512x512)\n"
+    "  --scales N,...         upsampleGrid scale factors (2,5)\n"
+    "  --iterations N,...     calculatePixel iteration limits (256)\n"
+    "  --samples N            timed samples per benchmark (30)\n"
+    "  --min-sample-ms MS     ops are batched up to this long (2)\n"
+    "  --filter TEXT          only benchmarks with TEXT in their name\n"
+    "  --out PATH             write the json there instead of stdout\n");
+}
+
+bool parseUnsignedList(const std::string& text, std::vector<uint32_t>& values)
+{
+  std::stringstream stream(text);
+  std::string part;
+  values.clear();
+  while (std::getline(stream, part, ','))
+  {
+    char* end = nullptr;
+    unsigned long value = std::strtoul(part.c_str(), &end, 10);
+    if (part.empty() || part[0] == '-' || *end != '\0' || value == 0)
+      return false;
+    values.push_back(value);
+  }
+  return !values.empty();
+}
+
+bool parseSizes(const std::string& text, std::vector<Size>& sizes)
+{
+  std::stringstream stream(text);
+  std::string part;
+  sizes.clear();
+  while (std::getline(stream, part, ','))
+  {
+    std::vector<uint32_t> sides;
+    size_t x = part.find('x');
+    if (x == std::string::npos ||
+        !parseUnsignedList(part.substr(0, x) + "," + part.substr(x + 1),
+                           sides) ||
+        sides.size() != 2)
+      return false;
+    sizes.push_back(Size{sides[0], sides[1]});
+  }
+  return !sizes.empty();
+}
+
+bool parseSettings(int argc, char** argv, Settings& settings)
+{
+  settings.sizes = {Size{128, 128}, Size{512, 512}};
+  settings.scales = {2, 5};
+  settings.iterations = {256};
+  settings.samples = 30;
+  settings.minSampleMs = 2;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string name = argv[i];
+    if (i + 1 >= argc)
+      return false;
+    std::string value = argv[++i];
+    std::vector<uint32_t> numbers;
+    bool ok = true;
+    if (name == "--sizes")
+      ok = parseSizes(value, settings.sizes);
+    else if (name == "--scales")
+      ok = parseUnsignedList(value, settings.scales);
+    else if (name == "--iterations")
+      ok = parseUnsignedList(value, settings.iterations);
+    else if (name == "--samples")
+    {
+      ok = parseUnsignedList(value, numbers) && numbers.size() == 1;
+      if (ok)
+        settings.samples = numbers[0];
+    }
+    else if (name == "--min-sample-ms")
+    {
+      char* end = nullptr;
+      settings.minSampleMs = std::strtod(value.c_str(), &end);
+      ok = *end == '\0' && settings.minSampleMs >= 0;
+    }
+    else if (name == "--filter")
+      settings.filter = value;
+    else if (name == "--out")
+      settings.outPath = value;
+    else
+      ok = false;
+    if (!ok)
+      return false;
+  }
+  return true;
+}
+
+double runMs(const std::function<void()>& op, uint64_t count)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < count; i++)
+    op();
+  return std::chrono::duration<double, std::milli>(
+           std::chrono::steady_clock::now() - start)
+    .count();
+}
+
+class Runner
+{
+public:
+  Runner(const Settings& settings) : m_settings(settings)
+  {
+  }
+
+  // times op, one call of which does itemsPerOp cells, pixels or lookups.
+  // Calls are batched until a sample takes long enough for the clock, and
+  // the first batch warms the caches
+  void run(const std::string& name, const Params& params, uint64_t itemsPerOp,
+           const std::function<void()>& op)
+  {
+    if (name.find(m_settings.filter) == std::string::npos)
+      return;
+    uint64_t opsPerSample = 1;
+    while (runMs(op, opsPerSample) < m_settings.minSampleMs &&
+           opsPerSample < (1ull << 30))
+      opsPerSample *= 2;
+
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < m_settings.samples; i++)
+      samples.push_back(runMs(op, opsPerSample) * 1e6 /
+                        (opsPerSample * itemsPerOp));
+    Result result{name, params, itemsPerOp, opsPerSample,
+                  automata::summarize(samples)};
+    m_results.push_back(result);
+
+    std::fprintf(stderr, "%s", name.c_str());
+    for (const auto& param : params)
+      std::fprintf(stderr, " %s=%llu", param.first.c_str(),
+                   (unsigned long long)param.second);
+    std::fprintf(stderr, ": %.3f ns per item\n", result.nsPerItem.median);
+  }
+
+  const std::vector<Result>& getResults()
+  {
+    return m_results;
+  }
+
+private:
+  const Settings& m_settings;
+  std::vector<Result> m_results;
+};
+
+void benchGrid(const Settings& settings, Runner& runner)
+{
+  for (const Size& size : settings.sizes)
+  {
+    Params params{{"width", size.width}, {"height", size.height}};
+    uint64_t cells = size.width * size.height;
+    Grid grid(size.width, size.height);
+    grid.fill(Color{12, 34, 56, 255});
+
+    runner.run("Grid::getCell", params, cells, [&]() {
+      uint64_t sum = 0;
+      for (uint64_t row = 0; row < size.height; row++)
+        for (uint64_t col = 0; col < size.width; col++)
+          sum += grid.getCell(row, col).g;
+      sink = sink + sum;
+    });
+
+    // sparse edits, every 16th cell like a brush stroke across the grid
+    runner.run("Grid::setCell+applyChanges", params, (cells + 15) / 16, [&]() {
+      for (uint64_t i = 0; i < cells; i += 16)
+        grid.setCell(i / size.width, i % size.width, Color{255, 0, 0, 255});
+      grid.applyChanges();
+    });
+
+    runner.run("Grid::fill", params, cells,
+               [&]() { grid.fill(Color{1, 2, 3, 255}); });
+
+    // back and forth, so the pan direction doesn't favor one way
+    bool forward = true;
+    runner.run("Grid::translate", params, cells, [&]() {
+      grid.translate(forward ? 3 : -3, forward ? 2 : -2);
+      forward = !forward;
+    });
+
+    for (uint32_t scale : settings.scales)
+    {
+      Params scaled = params;
+      scaled.push_back({"scale", scale});
+      Grid upsampled(size.width * scale, size.height * scale);
+      for (automata::SimdLevel level :
+           {automata::SimdLevel::Scalar, automata::SimdLevel::Avx2})
+      {
+        if (level > automata::getSimdLevel())
+          continue;
+        std::string name = std::string("upsampleGrid<") +
+                           automata::getSimdLevelName(level) + ">";
+        runner.run(name, scaled, cells * scale * scale,
+                   [&]() { upsampleGrid(grid, upsampled, scale, level); });
+      }
+    }
+  }
+}
+
+void benchPalette(Runner& runner)
+{
+  // the gradient the fractal window starts with, swept a few times around
+  Palette palette({Color{0, 0, 0, 255}, Color{255, 255, 255, 255}}, 100);
+  const uint32_t count = 1 << 16;
+  std::vector<float> indices(count);
+  for (uint32_t i = 0; i < count; i++)
+    indices[i] = i * 0.0173f;
+  std::vector<Color> colors(count);
+  Params params{{"count", count}, {"steps", palette.getNumSteps()}};
+
+  runner.run("Palette::getColor", params, count, [&]() {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < count; i++)
+      sum += palette.getColor(indices[i]).r;
+    sink = sink + sum;
+  });
+
+  for (int level = 0; level <= (int)automata::getSimdLevel(); level++)
+  {
+    // only the levels with a kernel of their own
+    if (level != (int)automata::SimdLevel::Scalar &&
+        level != (int)automata::SimdLevel::Avx2)
+      continue;
+    std::string name = std::string("Palette::colorize<") +
+                       automata::getSimdLevelName((automata::SimdLevel)level) +
+                       ">";
+    runner.run(name, params, count, [&]() {
+      palette.colorize(indices.data(), colors.data(), count,
+                       (automata::SimdLevel)level);
+    });
+  }
+}
+
+// points of the default window, cols x rows of them
+template <typename Number>
+void benchMandelbrot(const std::string& name, uint32_t cols, uint32_t rows,
+                     uint32_t iterations, Runner& runner)
+{
+  std::vector<Number> xs;
+  std::vector<Number> ys;
+  for (uint32_t i = 0; i < cols; i++)
+    xs.push_back(Number(-2.0 + 4.0 * i / cols));
+  for (uint32_t j = 0; j < rows; j++)
+    ys.push_back(Number(-1.0 + 2.0 * j / rows));
+  Params params{{"points", cols * rows}, {"iterations", iterations}};
+  runner.run(name, params, cols * rows, [&]() {
+    double sum = 0;
+    for (const Number& y : ys)
+      for (const Number& x : xs)
+        sum += mandelbrot::calculatePixel(x, y, Smooth::Logarithmic,
+                                          iterations);
+    sink = sink + (uint64_t)sum;
+  });
+}
+
+void benchFractals(const Settings& settings, Runner& runner)
+{
+  for (uint32_t iterations : settings.iterations)
+  {
+    const uint32_t cols = 64;
+    const uint32_t rows = 32;
+    Params params{{"points", cols * rows}, {"iterations", iterations}};
+    runner.run("mandelbrot::calculatePixel", params, cols * rows, [&]() {
+      double sum = 0;
+      for (uint32_t j = 0; j < rows; j++)
+        for (uint32_t i = 0; i < cols; i++)
+          sum += mandelbrot::calculatePixel(-2.0 + 4.0 * i / cols,
+                                            -1.0 + 2.0 * j / rows,
+                                            Smooth::Logarithmic, iterations);
+      sink = sink + (uint64_t)sum;
+    });
+    runner.run("julia::calculatePixel", params, cols * rows, [&]() {
+      double sum = 0;
+      for (uint32_t j = 0; j < rows; j++)
+        for (uint32_t i = 0; i < cols; i++)
+          sum += julia::calculatePixel(-2.0 + 4.0 * i / cols,
+                                       -1.0 + 2.0 * j / rows,
+                                       Smooth::Logarithmic, iterations, -1.0,
+                                       0.0);
+      sink = sink + (uint64_t)sum;
+    });
+    // an order of magnitude or two slower, fewer points keep samples short
+    benchMandelbrot<automata::DoubleDouble>(
+      "mandelbrot::calculatePixel<DoubleDouble>", 32, 16, iterations, runner);
+    benchMandelbrot<automata::QuadDouble>(
+      "mandelbrot::calculatePixel<QuadDouble>", 16, 8, iterations, runner);
+  }
+}
+
+// whether zooming in from deepZoomEnd goes through every number type past
+// doubles, so the ones benchmarked above are the ones deep zooms run in
+bool checkNumberTypes()
+{
+  bool used[4] = {};
+  for (double pixelSize = deepZoomEnd; pixelSize > 1e-300; pixelSize /= 2)
+    used[(int)automata::getNumberType(pixelSize)] = true;
+  bool ok = !used[(int)automata::NumberType::Double];
+  for (int type = (int)automata::NumberType::DoubleDouble;
+       type <= (int)automata::NumberType::BigFixed; type++)
+  {
+    if (!used[type])
+    {
+      std::fprintf(stderr, "deep zooms never use %s\n",
+                   automata::getNumberTypeName((automata::NumberType)type));
+      ok = false;
+    }
+  }
+  if (used[(int)automata::NumberType::Double])
+    std::fprintf(stderr, "deep zooms use Double\n");
+  return ok;
+}
+
+void writeJson(std::FILE* out, const Settings& settings,
+               const std::vector<Result>& results)
+{
+#if defined(_MSC_VER)
+  std::string compiler = "msvc " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+  std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+  std::string compiler = "gcc " __VERSION__;
+#else
+  std::string compiler = "unknown";
+#endif
+  std::fprintf(out,
+               "{\n\"context\": {\"compiler\": \"%s\", \"simd\": \"%s\", "
+               "\"samples\": %u, \"min_sample_ms\": %g},\n\"benchmarks\": [\n",
+               compiler.c_str(),
+               automata::getSimdLevelName(automata::getSimdLevel()),
+               settings.samples, settings.minSampleMs);
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const Result& result = results[i];
+    const automata::Summary& ns = result.nsPerItem;
+    std::fprintf(out, "{\"name\": \"%s\", \"params\": {", result.name.c_str());
+    for (size_t p = 0; p < result.params.size(); p++)
+      std::fprintf(out, "%s\"%s\": %llu", p ? ", " : "",
+                   result.params[p].first.c_str(),
+                   (unsigned long long)result.params[p].second);
+    std::fprintf(out,
+                 "}, \"items_per_op\": %llu, \"ops_per_sample\": %llu, "
+                 "\"ns_per_item\": {\"min\": %.4f, \"median\": %.4f, "
+                 "\"p99\": %.4f, \"max\": %.4f, \"mean\": %.4f, "
+                 "\"variance\": %.6g}, \"items_per_second\": %.6g}%s\n",
+                 (unsigned long long)result.itemsPerOp,
+                 (unsigned long long)result.opsPerSample, ns.min, ns.median,
+                 ns.p99, ns.max, ns.mean, ns.variance,
+                 ns.median > 0 ? 1e9 / ns.median : 0.0,
+                 i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(out, "]\n}\n");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+  Settings settings;
+  if (!parseSettings(argc, argv, settings))
+  {
+    printUsage();
+    return 1;
+  }
+  if (!checkNumberTypes())
+    return 1;
+
+  Runner runner(settings);
+  benchGrid(settings, runner);
+  benchPalette(runner);
+  benchFractals(settings, runner);
+
+  std::FILE* out = stdout;
+  if (!settings.outPath.empty())
+    out = std::fopen(settings.outPath.c_str(), "w");
+  if (!out)
+  {
+    std::fprintf(stderr, "can't write %s\n", settings.outPath.c_str());
+    return 1;
+  }
+  writeJson(out, settings, runner.getResults());
+  if (out != stdout)
+    std::fclose(out);
+  return 0;
+}
@@ -0,0 +1,600 @@
+// runs one automaton without a window and prints how fast it stepped as a
+// line of json, so throughput can be measured and compared on machines
+// without a gpu. See printUsage for the options
+
+#include "automata/Conways.hpp"
+#include "automata/Elementary.hpp"
+#include "automata/Fractal.hpp"
+#include "automata/FractalRenderer.hpp"
+#include "automata/Gradient.hpp"
+#include "automata/Presenter.hpp"
+#include "utils/CpuFeatures.hpp"
+#include "utils/ProcessMemory.hpp"
+#include "utils/Statistics.hpp"
+#include "utils/ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct Options
+{
+  std::string automaton;
+  uint64_t width;
+  uint64_t height;
+  uint32_t steps;
+  std::string rule; // in the automaton's own notation, empty for its default
+  uint32_t neighborhoodSize;
+  uint32_t threads;
+  uint32_t seed;
+  automata::SimdLevel simdLevel;
+  LifeEngine engine;
+  int hashlifeExponent;
+  int maxIterations;
+  Smooth smooth;
+  FractalBounds window;
+  bool hasWindow;
+  bool interiorChecks; // fractals, off runs the set to maxIterations
+  bool subdivide; // fractals, off iterates every pixel
+  uint32_t scale; // pixels per cell the steps are drawn at, 0 to not draw
+};
+
+// what every automaton comes back with
+struct Result
+{
+  std::string rule; // as it was run, empty if there is none
+  const char* simd; // the kernel that ran, null if there is only one
+  uint64_t cellsPerStep; // cells or pixels
+  std::vector<double> stepMs;
+  uint64_t checksum; // of the last image, to spot a step that changed
+  std::vector<double> presentMs; // publishing and drawing each step
+  uint64_t presentedChecksum; // of the last image drawn
+};
+
+void printUsage()
+{
+  std::fprintf(
+    stderr,
+    "usage: AutomataHeadless <automaton> [options]\n"
+    "automata: elementary, conways, gradient, mandelbrot, julia\n"
+    "  --width N, --height N  size in cells or pixels (512 x 512)\n"
+    "  --steps N              generations or renders to time (100)\n"
+    "  --rule R               elementary: a number like 30\n"
+    "                         conways: B3/S23 in Hensel notation, or\n"
+    "                         comma separated counts like B8,9/S6,7\n"
+    "                         gradient: sum ranges like B510-765/S255-765\n"
+    "                         julia: the seed, like -1,0\n"
+    "  --neighborhood N       4, 8, 12, 16 or 24 neighbors (8)\n"
+    "  --threads N            (every hardware thread)\n"
+    "  --seed N               of the random start (1)\n"
+    "  --simd L               scalar, sse41, avx2 or avx512 (the best)\n"
+    "  --engine E             conways: bytecells, bitboard or hashlife\n"
+    "  --hashlife-exponent N  2^N generations per hashlife step (0)\n"
+    "  --iterations N         fractals: most iterations per pixel (1000)\n"
+    "  --smooth S             none, linear, logarithmic or distance\n"
+    "  --window X0,X1,Y0,Y1   fractals: the part of the plane shown\n"
+    "  --no-interior-checks   fractals: iterate the set to the end\n"
+    "  --no-subdivide         fractals: iterate every pixel\n"
+    "  --scale N              cellular automata: draw every step at N\n"
+    "                         pixels a cell, as the window would (off)\n");
+}
+
+bool parseNumber(const std::string& text, double& value)
+{
+  char* end = nullptr;
+  value = std::strtod(text.c_str(), &end);
+  return !text.empty() && *end == '\0';
+}
+
+bool parseUnsigned(const std::string& text, uint64_t& value)
+{
+  char* end = nullptr;
+  value = std::strtoull(text.c_str(), &end, 10);
+  return !text.empty() && text[0] != '-' && *end == '\0';
+}
+
+// numbers separated by sep, like "-1,0"
+bool parseList(const std::string& text, char sep, std::vector<double>& values)
+{
+  std::stringstream stream(text);
+  std::string part;
+  values.clear();
+  while (std::getline(stream, part, sep))
+  {
+    double value;
+    if (!parseNumber(part, value))
+      return false;
+    values.push_back(value);
+  }
+  return !values.empty();
+}
+
+bool parseSimdLevel(const std::string& text, automata::SimdLevel& level)
+{
+  const char* names[] = {"scalar", "sse41", "avx2", "avx512"};
+  for (uint32_t i = 0; i < 4; i++)
+  {
+    if (text == names[i])
+    {
+      level = (automata::SimdLevel)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+  if (argc < 2)
+    return false;
+  options.automaton = argv[1];
+  options.width = 512;
+  options.height = 512;
+  options.steps = 100;
+  options.neighborhoodSize = 8;
+  options.threads = std::max(1u, std::thread::hardware_concurrency());
+  options.seed = 1;
+  options.simdLevel = automata::getSimdLevel();
+  options.engine = LifeEngine::ByteCells;
+  options.hashlifeExponent = 0;
+  options.maxIterations = 1000;
+  options.smooth = Smooth::Logarithmic;
+  options.hasWindow = false;
+  options.interiorChecks = true;
+  options.subdivide = true;
+  options.scale = 0;
+
+  for (int i = 2; i < argc; i++)
+  {
+    std::string name = argv[i];
+    // the flags without a value
+    if (name == "--no-interior-checks")
+    {
+      options.interiorChecks = false;
+      continue;
+    }
+    if (name == "--no-subdivide")
+    {
+      options.subdivide = false;
+      continue;
+    }
+    if (i + 1 >= argc)
+      return false;
+    std::string value = argv[++i];
+    uint64_t number = 0;
+    bool isNumber = parseUnsigned(value, number);
+    if (name == "--width" && isNumber && number > 0)
+      options.width = number;
+    else if (name == "--height" && isNumber && number > 0)
+      options.height = number;
+    else if (name == "--steps" && isNumber && number > 0)
+      options.steps = number;
+    else if (name == "--rule")
+      options.rule = value;
+    else if (name == "--neighborhood" && isNumber)
+      options.neighborhoodSize = number;
+    else if (name == "--threads" && isNumber && number > 0)
+      options.threads = number;
+    else if (name == "--seed" && isNumber)
+      options.seed = number;
+    else if (name == "--hashlife-exponent" && isNumber && number <= 40)
+      options.hashlifeExponent = number;
+    else if (name == "--iterations" && isNumber && number > 0)
+      options.maxIterations = number;
+    else if (name == "--scale" && isNumber && number <= 64)
+      options.scale = number;
+    else if (name == "--simd")
+    {
+      if (!parseSimdLevel(value, options.simdLevel))
+        return false;
+      // nothing can run past what the cpu has
+      options.simdLevel = std::min(options.simdLevel, automata::getSimdLevel());
+    }
+    else if (name == "--engine")
+    {
+      if (value == "bytecells")
+        options.engine = LifeEngine::ByteCells;
+      else if (value == "bitboard")
+        options.engine = LifeEngine::Bitboard;
+      else if (value == "hashlife")
+        options.engine = LifeEngine::Hashlife;
+      else
+        return false;
+    }
+    else if (name == "--smooth")
+    {
+      const char* names[] = {"none", "linear", "logarithmic", "distance"};
+      auto found = std::find(names, names + 4, value);
+      if (found == names + 4)
+        return false;
+      options.smooth = (Smooth)(found - names);
+    }
+    else if (name == "--window")
+    {
+      std::vector<double> bounds;
+      if (!parseList(value, ',', bounds) || bounds.size() != 4)
+        return false;
+      options.window =
+        FractalBounds{bounds[0], bounds[1], bounds[2], bounds[3]};
+      options.hasWindow = true;
+    }
+    else
+      return false;
+  }
+  const uint32_t sizes[] = {4, 8, 12, 16, 24};
+  return std::count(sizes, sizes + 5, options.neighborhoodSize) > 0;
+}
+
+// conways rules with counts past 8, like "B8,9,10/S6,7", which Hensel
+// notation can't write
+bool parseCountRule(const std::string& text, Rule& rule)
+{
+  size_t slash = text.find('/');
+  if (slash == std::string::npos || slash < 1 || text.size() < slash + 2 ||
+      std::tolower((unsigned char)text[0]) != 'b' ||
+      std::tolower((unsigned char)text[slash + 1]) != 's')
+    return false;
+  std::set<uint8_t> counts[2];
+  std::string parts[2] = {text.substr(1, slash - 1), text.substr(slash + 2)};
+  for (uint32_t i = 0; i < 2; i++)
+  {
+    std::vector<double> values;
+    if (parts[i].empty())
+      continue;
+    if (!parseList(parts[i], ',', values))
+      return false;
+    for (double value : values)
+    {
+      if (value < 0 || value > 255 || value != std::floor(value))
+        return false;
+      counts[i].insert((uint8_t)value);
+    }
+  }
+  rule = Rule(counts[0], counts[1]);
+  return true;
+}
+
+std::string countRuleToString(const Rule& rule)
+{
+  std::string text;
+  for (const std::set<uint8_t>* counts :
+       {&rule.m_birthConditions, &rule.m_surviveConditions})
+  {
+    text += text.empty() ? "B" : "/S";
+    for (uint8_t count : *counts)
+    {
+      if (count != *counts->begin())
+        text += ",";
+      text += std::to_string(count);
+    }
+  }
+  return text;
+}
+
+// "B510-765/S255-765"
+bool parseGradientRule(const std::string& text, GradientRule& rule)
+{
+  size_t slash = text.find('/');
+  if (slash == std::string::npos || slash < 1 || text.size() < slash + 2 ||
+      std::tolower((unsigned char)text[0]) != 'b' ||
+      std::tolower((unsigned char)text[slash + 1]) != 's')
+    return false;
+  std::string parts[2] = {text.substr(1, slash - 1), text.substr(slash + 2)};
+  std::pair<int, int> ranges[2];
+  for (uint32_t i = 0; i < 2; i++)
+  {
+    std::vector<double> values;
+    if (!parseList(parts[i], '-', values) || values.size() != 2)
+      return false;
+    ranges[i] = std::make_pair((int)values[0], (int)values[1]);
+  }
+  rule = GradientRule(ranges[0], ranges[1]);
+  return true;
+}
+
+// FNV-1a
+uint64_t getChecksum(Grid& grid)
+{
+  const uint8_t* data = grid.getData();
+  uint64_t size = grid.getWidth() * grid.getHeight() * 4;
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (uint64_t i = 0; i < size; i++)
+    hash = (hash ^ data[i]) * 0x100000001b3ull;
+  return hash;
+}
+
+double timeMs(const std::function<void()>& task)
+{
+  auto start = std::chrono::steady_clock::now();
+  task();
+  return std::chrono::duration<double, std::milli>(
+           std::chrono::steady_clock::now() - start)
+    .count();
+}
+
+// a software presenter the automaton publishes to, if its steps are drawn
+template <typename Automaton>
+SoftwarePresenter* attachPresenter(const Options& options,
+                                   Automaton& automaton)
+{
+  if (options.scale == 0)
+    return nullptr;
+  SoftwarePresenter* presenter = new SoftwarePresenter();
+  automaton.setPresenter(std::unique_ptr<Presenter>(presenter));
+  return presenter;
+}
+
+// publishes the last step and draws it, timed apart from the step
+template <typename Automaton>
+void presentStep(const Options& options, Automaton& automaton,
+                 SoftwarePresenter* presenter, Result& result)
+{
+  if (!presenter)
+    return;
+  result.presentMs.push_back(timeMs([&]() {
+    automaton.publish();
+    presenter->present(options.scale);
+  }));
+  result.presentedChecksum = getChecksum(presenter->getImage());
+}
+
+bool runElementary(const Options& options, Result& result)
+{
+  int rule = 30;
+  if (!options.rule.empty())
+  {
+    uint64_t number;
+    if (!parseUnsigned(options.rule, number) || number > 255)
+      return false;
+    rule = number;
+  }
+  Elementary elementary(options.height, options.width, 1, nullptr);
+  elementary.setRule(rule);
+  SoftwarePresenter* presenter = attachPresenter(options, elementary);
+  // a step works out every row from a new random first row
+  for (uint32_t i = 0; i < options.steps; i++)
+  {
+    result.stepMs.push_back(
+      timeMs([&]() { elementary.updateGrid(true, true); }));
+    presentStep(options, elementary, presenter, result);
+  }
+  result.rule = std::to_string(rule);
+  result.cellsPerStep = options.width * options.height;
+  result.checksum = getChecksum(elementary.getGrid());
+  return true;
+}
+
+bool runConways(const Options& options, Result& result)
+{
+  Rule rule(std::set<uint8_t>{3}, std::set<uint8_t>{2, 3});
+  if (!options.rule.empty() && !rule.parse(options.rule) &&
+      !parseCountRule(options.rule, rule))
+    return false;
+  Conways conways(options.height, options.width, 1, nullptr);
+  conways.setRule(rule, options.neighborhoodSize);
+  conways.setEngine(options.engine);
+  conways.setNumThreads(options.threads);
+  conways.setSimdLevel(options.simdLevel);
+  conways.setHashlifeExponent(options.hashlifeExponent);
+  conways.randomize();
+  SoftwarePresenter* presenter = attachPresenter(options, conways);
+  for (uint32_t i = 0; i < options.steps; i++)
+  {
+    result.stepMs.push_back(timeMs([&]() { conways.step(); }));
+    presentStep(options, conways, presenter, result);
+  }
+  // Hensel notation runs counts past 8 together
+  bool bigCounts = rule.m_birthConditions.upper_bound(8) !=
+                     rule.m_birthConditions.end() ||
+                   rule.m_surviveConditions.upper_bound(8) !=
+                     rule.m_surviveConditions.end();
+  result.rule = bigCounts ? countRuleToString(rule) : rule.toString();
+  if (options.engine == LifeEngine::ByteCells)
+    result.simd = automata::getSimdLevelName(
+      std::min(options.simdLevel, automata::SimdLevel::Avx2));
+  result.cellsPerStep = options.width * options.height;
+  // hashlife steps the whole universe 2^n generations at once, counted as
+  // the view stepped that many times
+  if (options.engine == LifeEngine::Hashlife)
+    result.cellsPerStep <<= options.hashlifeExponent;
+  result.checksum = getChecksum(conways.getGrid());
+  return true;
+}
+
+bool runGradient(const Options& options, Result& result)
+{
+  GradientRule rule(std::make_pair(510, 765), std::make_pair(255, 765));
+  if (!options.rule.empty() && !parseGradientRule(options.rule, rule))
+    return false;
+  Gradient gradient(options.height, options.width, 1, nullptr);
+  gradient.setRule(rule, options.neighborhoodSize);
+  gradient.setNumThreads(options.threads);
+  gradient.randomize();
+  SoftwarePresenter* presenter = attachPresenter(options, gradient);
+  for (uint32_t i = 0; i < options.steps; i++)
+  {
+    result.stepMs.push_back(timeMs([&]() { gradient.step(); }));
+    presentStep(options, gradient, presenter, result);
+  }
+  result.rule = "B" + std::to_string(rule.m_birthConditions.first) + "-" +
+                std::to_string(rule.m_birthConditions.second) + "/S" +
+                std::to_string(rule.m_surviveConditions.first) + "-" +
+                std::to_string(rule.m_surviveConditions.second);
+  result.cellsPerStep = options.width * options.height;
+  result.checksum = getChecksum(gradient.getGrid());
+  return true;
+}
+
+// a step renders every pixel from scratch in tiles across the threads, as
+// the last pass of the window does, then colors them
+bool runFractal(const Options& options, FractalType type, Result& result)
+{
+  double seedX = -1;
+  double seedY = 0;
+  if (type == FractalType::Julia && !options.rule.empty())
+  {
+    std::vector<double> seed;
+    if (!parseList(options.rule, ',', seed) || seed.size() != 2)
+      return false;
+    seedX = seed[0];
+    seedY = seed[1];
+  }
+  Grid grid(options.width, options.height);
+  IterationBuffer iterations(options.width, options.height);
+  Palette palette({Color{0, 0, 0, 255}, Color{255, 255, 255, 255}});
+  // 4 wide like the window, as tall as the image needs
+  double halfHeight = 2.0 * options.height / options.width;
+  FractalInfo f;
+  f.pGrid = &grid;
+  f.smooth = options.smooth;
+  f.palette = &palette;
+  f.minDistance = 0.01f;
+  f.maxIterations = options.maxIterations;
+  f.imageSize = Int2{(uint32_t)options.width, (uint32_t)options.height};
+  f.pView = nullptr;
+  f.pTexture = nullptr;
+  f.pDevice = nullptr;
+  f.setColor = ImVec4(0, 0, 0, 1);
+  f.distanceColor = ImVec4(1, 1, 1, 1);
+  f.type = type;
+  f.window = options.hasWindow
+               ? options.window
+               : FractalBounds{-2.0, 2.0, -halfHeight, halfHeight};
+  f.seedX = seedX;
+  f.seedY = seedY;
+  f.simdLevel = options.simdLevel;
+  f.stats = RenderStats{};
+  f.deepZoom = DeepZoom{false,   automata::BigFixed(), automata::BigFixed(),
+                        nullptr, true,                 true,
+                        automata::NumberType::Double};
+  f.interiorChecks = options.interiorChecks;
+  f.subdivide = options.subdivide;
+  f.pIterations = &iterations;
+
+  // the calling thread works through tiles too
+  automata::ThreadPool pool(options.threads - 1);
+  const uint32_t tileSize = fractal::FractalRenderer::tileSize;
+  uint32_t tilesX = (options.width + tileSize - 1) / tileSize;
+  uint32_t tilesY = (options.height + tileSize - 1) / tileSize;
+  RenderPass pass{1, 0, nullptr, {}, nullptr};
+  for (uint32_t i = 0; i < options.steps; i++)
+  {
+    iterations.clear();
+    result.stepMs.push_back(timeMs([&]() {
+      pool.parallelFor(tilesX * tilesY, [&](uint32_t index) {
+        Int2 topLeft{index % tilesX * tileSize, index / tilesX * tileSize};
+        Int2 bottomRight{
+          std::min<uint32_t>(topLeft.x + tileSize, options.width),
+          std::min<uint32_t>(topLeft.y + tileSize, options.height)};
+        fractal::getFractalPixels(f, topLeft, bottomRight, pass);
+      });
+      fractal::colorize(f, Int2{0, 0}, f.imageSize);
+    }));
+  }
+  if (type == FractalType::Julia)
+  {
+    std::ostringstream rule;
+    rule << seedX << "," << seedY;
+    result.rule = rule.str();
+  }
+  result.simd = automata::getSimdLevelName(options.simdLevel);
+  result.cellsPerStep = options.width * options.height;
+  result.checksum = getChecksum(grid);
+  return true;
+}
+
+void printResult(const Options& options, const Result& result)
+{
+  bool fractal =
+    options.automaton == "mandelbrot" || options.automaton == "julia";
+  double totalMs = 0;
+  for (double ms : result.stepMs)
+    totalMs += ms;
+  double seconds = totalMs / 1000;
+  double perSecond =
+    seconds > 0 ? result.cellsPerStep * result.stepMs.size() / seconds : 0;
+  const char* engines[] = {"bytecells", "bitboard", "hashlife"};
+
+  std::printf("{\"automaton\":\"%s\"", options.automaton.c_str());
+  if (options.automaton == "conways")
+    std::printf(",\"engine\":\"%s\"", engines[(int)options.engine]);
+  std::printf(",\"width\":%llu,\"height\":%llu,\"steps\":%zu",
+              (unsigned long long)options.width,
+              (unsigned long long)options.height, result.stepMs.size());
+  if (!result.rule.empty())
+    std::printf(",\"rule\":\"%s\"", result.rule.c_str());
+  std::printf(",\"threads\":%u", options.threads);
+  if (result.simd)
+    std::printf(",\"simd\":\"%s\"", result.simd);
+  if (fractal)
+    std::printf(",\"interior_checks\":%s,\"subdivide\":%s",
+                options.interiorChecks ? "true" : "false",
+                options.subdivide ? "true" : "false");
+  automata::Summary steps = automata::summarize(result.stepMs);
+  std::printf(",\"seconds\":%.6f,\"step_ms_median\":%.4f"
+              ",\"step_ms_p99\":%.4f,\"step_ms_min\":%.4f",
+              seconds, steps.median, steps.p99, steps.min);
+  std::printf(",\"%s\":%.6g",
+              fractal ? "pixels_per_second" : "cells_per_second", perSecond);
+  if (!result.presentMs.empty())
+  {
+    automata::Summary present = automata::summarize(result.presentMs);
+    std::printf(",\"scale\":%u,\"present_ms_median\":%.4f"
+                ",\"present_ms_p99\":%.4f,\"presented_checksum\":\"%016llx\"",
+                options.scale, present.median, present.p99,
+                (unsigned long long)result.presentedChecksum);
+  }
+  std::printf(",\"peak_rss_bytes\":%llu,\"checksum\":\"%016llx\"}\n",
+              (unsigned long long)automata::getPeakResidentBytes(),
+              (unsigned long long)result.checksum);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    printUsage();
+    return 1;
+  }
+  std::srand(options.seed);
+
+  Result result{};
+  bool ran = false;
+  if (options.automaton == "elementary")
+    ran = runElementary(options, result);
+  else if (options.automaton == "conways")
+    ran = runConways(options, result);
+  else if (options.automaton == "gradient")
+    ran = runGradient(options, result);
+  else if (options.automaton == "mandelbrot")
+    ran = runFractal(options, FractalType::Mandelbrot, result);
+  else if (options.automaton == "julia")
+    ran = runFractal(options, FractalType::Julia, result);
+  else
+  {
+    printUsage();
+    return 1;
+  }
+  if (!ran)
+  {
+    std::fprintf(stderr, "not a %s rule: %s\n", options.automaton.c_str(),
+                 options.rule.c_str());
+    return 1;
+  }
+  printResult(options, result);
+  return 0;
+}
@@ -6,6 +6,8 @@
 #include "automata/Conways.hpp"
 #include "automata/Gradient.hpp"
 #include "automata/Mandelbrot.hpp"
+#include "utils/Profiler.hpp"
+#include "utils/ProfilerOverlay.hpp"
 
 #include <tchar.h>
 
@@ -66,9 +68,11 @@ int main(int, char **)
 
   // Our state
   bool show_demo_window = true;
+  bool show_profiler = true;
   bool show_another_window = false;
   ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
+  automata::profiler::setThreadName("main");
   bool done = false;
   while (!done)
   {
@@ -85,64 +89,76 @@ int main(int, char **)
     }
     if (done)
       break;
-
-    // Start the Dear ImGui frame
-    ImGui_ImplDX11_NewFrame();
-    ImGui_ImplWin32_NewFrame();
-    ImGui::NewFrame();
-
-    if (show_demo_window)
-      ImGui::ShowDemoWindow(&show_demo_window);
-
-    // static Elementary elementary(100, 200, 5, g_pd3dDevice);
-    // static Conways conways(100, 200, 5, g_pd3dDevice);
-    // static Gradient gradient(100, 200, 5, g_pd3dDevice);
-    // static Mandelbrot mandelbrot(500, 1000, g_pd3dDevice);
-
-    // make next window fullscreen
-    const ImGuiViewport* viewport = ImGui::GetMainViewport();
-    ImGui::SetNextWindowPos(viewport->Pos);
-    ImGui::SetNextWindowSize(viewport->Size);
-    ImGuiWindowFlags flags = 0;
-    flags |= ImGuiWindowFlags_NoDecoration;
-    flags |= ImGuiWindowFlags_NoMove;
-    flags |= ImGuiWindowFlags_NoSavedSettings;
-    flags |= ImGuiWindowFlags_NoBringToFrontOnFocus;
-
-    ImGui::Begin("Cellular Automata", NULL, flags);
-    ImGui::BeginTabBar("groups");
-    // if (ImGui::BeginTabItem("Elementary Automata"))
-    // {
-    //   elementary.showAutomataWindow();
-    //   ImGui::EndTabItem();
-    // }
-    // if (ImGui::BeginTabItem("Conway's Game of Life"))
-    // {
-    //   conways.showAutomataWindow();
-    //   ImGui::EndTabItem();
-    // }
-    // if (ImGui::BeginTabItem("Gradient Automata"))
-    // {
-    //   gradient.showAutomataWindow();
-    //   ImGui::EndTabItem();
-    // }
-    if (ImGui::BeginTabItem("Mandelbrot Set"))
+    automata::ProfileZone frameZone("Frame");
     {
-      fractal::showAutomataWindow(g_pd3dDevice);
+      automata::ProfileZone zone("UI");
+
+      // Start the Dear ImGui frame
+      ImGui_ImplDX11_NewFrame();
+      ImGui_ImplWin32_NewFrame();
+      ImGui::NewFrame();
+
+      if (show_demo_window)
+        ImGui::ShowDemoWindow(&show_demo_window);
+      if (show_profiler)
+        automata::showProfilerOverlay(&show_profiler);
+
+      // static Elementary elementary(100, 200, 5, g_pd3dDevice);
+      // static Conways conways(100, 200, 5, g_pd3dDevice);
+      // static Gradient gradient(100, 200, 5, g_pd3dDevice);
+      // static Mandelbrot mandelbrot(500, 1000, g_pd3dDevice);
+
+      // make next window fullscreen
+      const ImGuiViewport* viewport = ImGui::GetMainViewport();
+      ImGui::SetNextWindowPos(viewport->Pos);
+      ImGui::SetNextWindowSize(viewport->Size);
+      ImGuiWindowFlags flags = 0;
+      flags |= ImGuiWindowFlags_NoDecoration;
+      flags |= ImGuiWindowFlags_NoMove;
+      flags |= ImGuiWindowFlags_NoSavedSettings;
+      flags |= ImGuiWindowFlags_NoBringToFrontOnFocus;
+
+      ImGui::Begin("Cellular Automata", NULL, flags);
+      ImGui::BeginTabBar("groups");
+      // if (ImGui::BeginTabItem("Elementary Automata"))
+      // {
+      //   elementary.showAutomataWindow();
+      //   ImGui::EndTabItem();
+      // }
+      // if (ImGui::BeginTabItem("Conway's Game of Life"))
+      // {
+      //   conways.showAutomataWindow();
+      //   ImGui::EndTabItem();
+      // }
+      // if (ImGui::BeginTabItem("Gradient Automata"))
+      // {
+      //   gradient.showAutomataWindow();
+      //   ImGui::EndTabItem();
+      // }
+      if (ImGui::BeginTabItem("Mandelbrot Set"))
+      {
+        fractal::showAutomataWindow(g_pd3dDevice);
+      }
+      ImGui::EndTabBar();
+      ImGui::End();
     }
-    ImGui::EndTabBar();
-    ImGui::End();
 
     // Rendering
-    ImGui::Render();
-    const float clear_color_with_alpha[4] = {
-      clear_color.x * clear_color.w, clear_color.y * clear_color.w,
-      clear_color.z * clear_color.w, clear_color.w};
-    g_pd3dDeviceContext->OMSetRenderTargets(1, &g_mainRenderTargetView, NULL);
-    g_pd3dDeviceContext->ClearRenderTargetView(g_mainRenderTargetView,
-                                               clear_color_with_alpha);
-    ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+    {
+      automata::ProfileZone zone("Render");
+      ImGui::Render();
+      const float clear_color_with_alpha[4] = {
+        clear_color.x * clear_color.w, clear_color.y * clear_color.w,
+        clear_color.z * clear_color.w, clear_color.w};
+      g_pd3dDeviceContext->OMSetRenderTargets(1, &g_mainRenderTargetView,
+                                              NULL);
+      g_pd3dDeviceContext->ClearRenderTargetView(g_mainRenderTargetView,
+                                                 clear_color_with_alpha);
+      ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+    }
 
+    // waits for vsync, so it's timed apart from the frame's own work
+    automata::ProfileZone presentZone("Present");
     g_pSwapChain->Present(1, 0); // Present with vsync
     // g_pSwapChain->Present(0, 0); // Present without vsync
   }
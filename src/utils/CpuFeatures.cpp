@@ -0,0 +1,67 @@
+#include "CpuFeatures.hpp"
+
+#if defined(AUTOMATA_X86) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace
+{
+automata::SimdLevel detectSimdLevel()
+{
+#if defined(AUTOMATA_X86) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  bool sse41 = info[2] & (1 << 19);
+  bool osxsave = info[2] & (1 << 27);
+  bool avx = info[2] & (1 << 28);
+  // the os has to save the ymm registers on context switches
+  bool ymmEnabled = osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+  // and the opmask and zmm registers for avx-512
+  bool zmmEnabled = ymmEnabled && (_xgetbv(0) & 0xe6) == 0xe6;
+  __cpuidex(info, 7, 0);
+  bool avx2 = info[1] & (1 << 5);
+  bool avx512f = info[1] & (1 << 16);
+
+  if (zmmEnabled && avx512f)
+    return automata::SimdLevel::Avx512;
+  if (ymmEnabled && avx2)
+    return automata::SimdLevel::Avx2;
+  if (sse41)
+    return automata::SimdLevel::Sse41;
+#elif defined(AUTOMATA_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return automata::SimdLevel::Avx512;
+  if (__builtin_cpu_supports("avx2"))
+    return automata::SimdLevel::Avx2;
+  if (__builtin_cpu_supports("sse4.1"))
+    return automata::SimdLevel::Sse41;
+#endif
+  return automata::SimdLevel::Scalar;
+}
+} // namespace
+
+namespace automata
+{
+SimdLevel getSimdLevel()
+{
+  static SimdLevel level = detectSimdLevel();
+  return level;
+}
+
+const char* getSimdLevelName(SimdLevel level)
+{
+  switch (level)
+  {
+  case SimdLevel::Sse41:
+    return "SSE4.1";
+  case SimdLevel::Avx2:
+    return "AVX2";
+  case SimdLevel::Avx512:
+    return "AVX-512";
+  default:
+    return "Scalar";
+  }
+}
+} // namespace automata
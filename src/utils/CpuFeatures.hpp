@@ -0,0 +1,26 @@
+#ifndef UTILS_CPU_FEATURES
+#define UTILS_CPU_FEATURES
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) ||          \
+  defined(__i386__)
+#define AUTOMATA_X86
+#endif
+
+namespace automata
+{
+// ordered, so a level can run every kernel below it
+enum class SimdLevel
+{
+  Scalar,
+  Sse41,
+  Avx2,
+  Avx512 // AVX-512F
+};
+
+// the best level both the cpu and the os support, detected once
+SimdLevel getSimdLevel();
+
+const char* getSimdLevelName(SimdLevel level);
+} // namespace automata
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef UTILS_D3D11_FORWARD
+#define UTILS_D3D11_FORWARD
+
+// the automata only hold on to these, d3d11.h is included where they are
+// drawn, so the simulation cores build without the windows sdk
+struct ID3D11Device;
+struct ID3D11SamplerState;
+struct ID3D11ShaderResourceView;
+struct ID3D11Texture2D;
+
+#endif
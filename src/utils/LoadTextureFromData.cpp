@@ -1,9 +1,13 @@
 #include "LoadTextureFromData.hpp"
+#include "Profiler.hpp"
+
 namespace automata
 {
     // Simple helper function to load an image into a DX11 texture with common settings
     bool LoadTextureFromData(unsigned char* image_data, ID3D11ShaderResourceView** out_srv, ID3D11Texture2D** out_texture, ID3D11Device* pd3dDevice, int width, int height)
     {
+        ProfileZone zone("LoadTextureFromData");
+
         // Create texture
         D3D11_TEXTURE2D_DESC desc;
         ZeroMemory(&desc, sizeof(desc));
@@ -0,0 +1,353 @@
+#include "Numeric.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+using automata::numeric::quickTwoSum;
+using automata::numeric::twoProduct;
+using automata::numeric::twoSum;
+
+// a + b + c, with the two errors left in b and c
+void threeSum(double& a, double& b, double& c)
+{
+  double t2;
+  double t3;
+  double t1 = twoSum(a, b, t2);
+  a = twoSum(c, t1, t3);
+  b = twoSum(t2, t3, c);
+}
+
+// threeSum where the second error isn't needed
+void threeSum2(double& a, double& b, double c)
+{
+  double t2;
+  double t3;
+  double t1 = twoSum(a, b, t2);
+  a = twoSum(c, t1, t3);
+  b = t2 + t3;
+}
+
+// five overlapping parts into four that don't overlap
+void renormalize(double& c0, double& c1, double& c2, double& c3, double c4)
+{
+  if (std::isinf(c0))
+    return;
+  double s0 = quickTwoSum(c3, c4, c4);
+  s0 = quickTwoSum(c2, s0, c3);
+  s0 = quickTwoSum(c1, s0, c2);
+  c0 = quickTwoSum(c0, s0, c1);
+
+  s0 = c0;
+  double s1 = c1;
+  double s2 = 0;
+  double s3 = 0;
+  if (s1 != 0)
+  {
+    s1 = quickTwoSum(s1, c2, s2);
+    if (s2 != 0)
+    {
+      s2 = quickTwoSum(s2, c3, s3);
+      if (s3 != 0)
+        s3 += c4;
+      else
+        s2 = quickTwoSum(s2, c4, s3);
+    }
+    else
+    {
+      s1 = quickTwoSum(s1, c3, s2);
+      if (s2 != 0)
+        s2 = quickTwoSum(s2, c4, s3);
+      else
+        s1 = quickTwoSum(s1, c4, s2);
+    }
+  }
+  else
+  {
+    s0 = quickTwoSum(s0, c2, s1);
+    if (s1 != 0)
+    {
+      s1 = quickTwoSum(s1, c3, s2);
+      if (s2 != 0)
+        s2 = quickTwoSum(s2, c4, s3);
+      else
+        s1 = quickTwoSum(s1, c4, s2);
+    }
+    else
+    {
+      s0 = quickTwoSum(s0, c3, s1);
+      if (s1 != 0)
+        s1 = quickTwoSum(s1, c4, s2);
+      else
+        s0 = quickTwoSum(s0, c4, s1);
+    }
+  }
+  c0 = s0;
+  c1 = s1;
+  c2 = s2;
+  c3 = s3;
+}
+
+// the leading doubles of a fixed point number, each taken off before
+// rounding the next
+void splitBigFixed(automata::BigFixed value, double* parts, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++)
+  {
+    parts[i] = value.toDouble();
+    value = value - automata::BigFixed(parts[i]);
+  }
+}
+} // namespace
+
+namespace automata
+{
+BigFixed::BigFixed(double value)
+  : BigFixed(value, 2)
+{
+  // the lowest bit of the mantissa sets how many limbs it takes
+  int exponent;
+  std::frexp(value, &exponent);
+  int32_t lowestBit = exponent - 53;
+  if (value != 0 && lowestBit < -64)
+    *this = BigFixed(value, (-lowestBit + 31) / 32);
+}
+
+BigFixed::BigFixed(double value, uint32_t fractionLimbs)
+  : m_limbs(fractionLimbs + 1, 0)
+{
+  // the fraction of a small negative number would round to 1, so negatives
+  // are built from their magnitude
+  if (value < 0)
+  {
+    *this = -BigFixed(-value, fractionLimbs);
+    return;
+  }
+  double integer = std::floor(value);
+  double fraction = value - integer;
+  m_limbs.back() = (uint32_t)(int32_t)integer;
+  for (uint32_t i = fractionLimbs; i-- > 0 && fraction != 0;)
+  {
+    fraction = std::ldexp(fraction, 32);
+    double limb = std::floor(fraction);
+    m_limbs[i] = (uint32_t)limb;
+    fraction -= limb;
+  }
+}
+
+uint32_t BigFixed::getLimbsFor(double resolution)
+{
+  if (!(resolution > 0))
+    return 2;
+  int exponent;
+  std::frexp(resolution, &exponent);
+  uint32_t bits = exponent < 0 ? -exponent : 0;
+  return std::max(2u, bits / 32 + 2);
+}
+
+void BigFixed::setFractionLimbs(uint32_t fractionLimbs)
+{
+  uint32_t current = getFractionLimbs();
+  if (fractionLimbs > current)
+    m_limbs.insert(m_limbs.begin(), fractionLimbs - current, 0);
+  else
+    m_limbs.erase(m_limbs.begin(), m_limbs.begin() + (current - fractionLimbs));
+}
+
+double BigFixed::toDouble() const
+{
+  // the fraction of a small negative number is nearly 1, which would cancel
+  // against the integer part
+  BigFixed magnitude = -*this;
+  if (isNegative() && !magnitude.isNegative())
+    return -magnitude.toDouble();
+  double value = 0;
+  int32_t fractionBits = 32 * getFractionLimbs();
+  for (uint32_t i = 0; i < m_limbs.size(); i++)
+    value += std::ldexp((double)m_limbs[i], 32 * (int32_t)i - fractionBits);
+  return value;
+}
+
+BigFixed BigFixed::operator+(const BigFixed& other) const
+{
+  uint32_t limbs = std::max(getFractionLimbs(), other.getFractionLimbs());
+  BigFixed a = *this;
+  BigFixed b = other;
+  a.setFractionLimbs(limbs);
+  b.setFractionLimbs(limbs);
+  uint64_t carry = 0;
+  for (uint32_t i = 0; i < a.m_limbs.size(); i++)
+  {
+    uint64_t sum = (uint64_t)a.m_limbs[i] + b.m_limbs[i] + carry;
+    a.m_limbs[i] = (uint32_t)sum;
+    carry = sum >> 32;
+  }
+  return a;
+}
+
+BigFixed BigFixed::operator-(const BigFixed& other) const
+{
+  return *this + -other;
+}
+
+BigFixed BigFixed::operator-() const
+{
+  BigFixed negated = *this;
+  uint64_t carry = 1;
+  for (uint32_t& limb : negated.m_limbs)
+  {
+    uint64_t sum = (uint64_t)(uint32_t)~limb + carry;
+    limb = (uint32_t)sum;
+    carry = sum >> 32;
+  }
+  return negated;
+}
+
+BigFixed BigFixed::operator*(const BigFixed& other) const
+{
+  uint32_t limbs = std::max(getFractionLimbs(), other.getFractionLimbs());
+  BigFixed a = isNegative() ? -*this : *this;
+  BigFixed b = other.isNegative() ? -other : other;
+  a.setFractionLimbs(limbs);
+  b.setFractionLimbs(limbs);
+
+  // schoolbook on the magnitudes, then the limbs below the fraction are
+  // dropped
+  uint32_t n = a.m_limbs.size();
+  std::vector<uint32_t> product(2 * n, 0);
+  for (uint32_t i = 0; i < n; i++)
+  {
+    uint64_t carry = 0;
+    for (uint32_t j = 0; j < n; j++)
+    {
+      uint64_t term =
+        (uint64_t)a.m_limbs[i] * b.m_limbs[j] + product[i + j] + carry;
+      product[i + j] = (uint32_t)term;
+      carry = term >> 32;
+    }
+    product[i + n] = (uint32_t)carry;
+  }
+
+  BigFixed result(0, limbs);
+  std::copy(product.begin() + limbs, product.begin() + limbs + n,
+            result.m_limbs.begin());
+  return isNegative() != other.isNegative() ? -result : result;
+}
+
+DoubleDouble::DoubleDouble(const BigFixed& value)
+{
+  double parts[2];
+  splitBigFixed(value, parts, 2);
+  hi = numeric::quickTwoSum(parts[0], parts[1], lo);
+}
+
+QuadDouble::QuadDouble(const BigFixed& value)
+{
+  splitBigFixed(value, x, 4);
+  renormalize(x[0], x[1], x[2], x[3], 0);
+}
+
+QuadDouble QuadDouble::operator+(const QuadDouble& other) const
+{
+  const double* a = x;
+  const double* b = other.x;
+  double t0;
+  double t1;
+  double t2;
+  double t3;
+  double s0 = twoSum(a[0], b[0], t0);
+  double s1 = twoSum(a[1], b[1], t1);
+  double s2 = twoSum(a[2], b[2], t2);
+  double s3 = twoSum(a[3], b[3], t3);
+
+  s1 = twoSum(s1, t0, t0);
+  threeSum(s2, t0, t1);
+  threeSum2(s3, t0, t2);
+  t0 = t0 + t1 + t3;
+
+  QuadDouble sum;
+  renormalize(s0, s1, s2, s3, t0);
+  sum.x[0] = s0;
+  sum.x[1] = s1;
+  sum.x[2] = s2;
+  sum.x[3] = s3;
+  return sum;
+}
+
+QuadDouble QuadDouble::operator*(const QuadDouble& other) const
+{
+  const double* a = x;
+  const double* b = other.x;
+  double q0;
+  double q1;
+  double q2;
+  double q3;
+  double q4;
+  double q5;
+  double p0 = twoProduct(a[0], b[0], q0);
+  double p1 = twoProduct(a[0], b[1], q1);
+  double p2 = twoProduct(a[1], b[0], q2);
+  double p3 = twoProduct(a[0], b[2], q3);
+  double p4 = twoProduct(a[1], b[1], q4);
+  double p5 = twoProduct(a[2], b[0], q5);
+
+  // the terms of order 1
+  threeSum(p1, p2, q0);
+
+  // the terms of order 2
+  threeSum(p2, q1, q2);
+  threeSum(p3, p4, p5);
+  double t0;
+  double t1;
+  double s0 = twoSum(p2, p3, t0);
+  double s1 = twoSum(q1, p4, t1);
+  double s2 = q2 + p5;
+  s1 = twoSum(s1, t0, t0);
+  s2 += (t0 + t1);
+
+  // the terms of order 3, roughly
+  s1 += a[0] * b[3] + a[1] * b[2] + a[2] * b[1] + a[3] * b[0] + q0 + q3 + q4 +
+        q5;
+
+  QuadDouble product;
+  renormalize(p0, p1, s0, s1, s2);
+  product.x[0] = p0;
+  product.x[1] = p1;
+  product.x[2] = s0;
+  product.x[3] = s1;
+  return product;
+}
+
+NumberType getNumberType(double resolution)
+{
+  // bits below the unit the coordinates need, and a margin for the error
+  // iterating adds
+  int exponent;
+  std::frexp(resolution, &exponent);
+  int32_t bits = -exponent + 24;
+  if (bits <= 53)
+    return NumberType::Double;
+  if (bits <= 106)
+    return NumberType::DoubleDouble;
+  if (bits <= 212)
+    return NumberType::QuadDouble;
+  return NumberType::BigFixed;
+}
+
+const char* getNumberTypeName(NumberType type)
+{
+  switch (type)
+  {
+  case NumberType::Double:
+    return "double";
+  case NumberType::DoubleDouble:
+    return "double-double";
+  case NumberType::QuadDouble:
+    return "quad-double";
+  case NumberType::BigFixed:
+    return "fixed point";
+  }
+  return "";
+}
+} // namespace automata
@@ -0,0 +1,209 @@
+#ifndef UTILS_NUMERIC
+#define UTILS_NUMERIC
+
+#include <cstdint>
+#include <vector>
+
+namespace automata
+{
+// a fixed point number with a signed 32 bit integer part and as many 32 bit
+// limbs of fraction as asked for, in two's complement. Slow, but exact
+// enough for coordinates far past what a double can tell apart
+class BigFixed
+{
+public:
+  // with as many limbs as it takes to hold value exactly
+  explicit BigFixed(double value = 0);
+
+  BigFixed(double value, uint32_t fractionLimbs);
+
+  // fraction limbs needed to tell apart points resolution apart, with a
+  // limb to spare for rounding
+  static uint32_t getLimbsFor(double resolution);
+
+  uint32_t getFractionLimbs() const
+  {
+    return m_limbs.size() - 1;
+  }
+
+  // keeps the value, dropping the lowest limbs when there are fewer
+  void setFractionLimbs(uint32_t fractionLimbs);
+
+  double toDouble() const;
+
+  bool isNegative() const
+  {
+    return m_limbs.back() >> 31;
+  }
+
+  // operands of different precision give a result as precise as the more
+  // precise one
+  BigFixed operator+(const BigFixed& other) const;
+  BigFixed operator-(const BigFixed& other) const;
+  BigFixed operator*(const BigFixed& other) const;
+  BigFixed operator-() const;
+
+  BigFixed& operator+=(const BigFixed& other)
+  {
+    return *this = *this + other;
+  }
+
+private:
+  std::vector<uint32_t> m_limbs; // lowest first, the last is the integer part
+};
+
+namespace numeric
+{
+// a + b as the rounded sum and the error, which is exact
+inline double twoSum(double a, double b, double& error)
+{
+  double sum = a + b;
+  double b_virtual = sum - a;
+  error = (a - (sum - b_virtual)) + (b - b_virtual);
+  return sum;
+}
+
+// twoSum for when |a| >= |b|
+inline double quickTwoSum(double a, double b, double& error)
+{
+  double sum = a + b;
+  error = b - (sum - a);
+  return sum;
+}
+
+// Dekker's product, splitting both sides into 26 bit halves so it doesn't
+// need a fused multiply add
+inline double twoProduct(double a, double b, double& error)
+{
+  const double splitter = 134217729.0; // 2^27 + 1
+  double t = splitter * a;
+  double a_hi = t - (t - a);
+  double a_lo = a - a_hi;
+  t = splitter * b;
+  double b_hi = t - (t - b);
+  double b_lo = b - b_hi;
+  double product = a * b;
+  error = ((a_hi * b_hi - product) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+  return product;
+}
+} // namespace numeric
+
+// an unevaluated sum of two doubles, about 106 bits of mantissa
+struct DoubleDouble
+{
+  DoubleDouble(double value = 0) : hi(value), lo(0)
+  {
+  }
+
+  DoubleDouble(double high, double low) : hi(high), lo(low)
+  {
+  }
+
+  explicit DoubleDouble(const BigFixed& value);
+
+  DoubleDouble operator+(const DoubleDouble& other) const
+  {
+    double e;
+    double f;
+    double s = numeric::twoSum(hi, other.hi, e);
+    double t = numeric::twoSum(lo, other.lo, f);
+    e += t;
+    s = numeric::quickTwoSum(s, e, e);
+    e += f;
+    s = numeric::quickTwoSum(s, e, e);
+    return DoubleDouble(s, e);
+  }
+
+  DoubleDouble operator-() const
+  {
+    return DoubleDouble(-hi, -lo);
+  }
+
+  DoubleDouble operator-(const DoubleDouble& other) const
+  {
+    return *this + -other;
+  }
+
+  DoubleDouble operator*(const DoubleDouble& other) const
+  {
+    double e;
+    double p = numeric::twoProduct(hi, other.hi, e);
+    e += hi * other.lo + lo * other.hi;
+    p = numeric::quickTwoSum(p, e, e);
+    return DoubleDouble(p, e);
+  }
+
+  double hi;
+  double lo;
+};
+
+// an unevaluated sum of four doubles, about 212 bits of mantissa. The sums
+// and products are the quicker, slightly less exact ones from Hida, Li and
+// Bailey's qd library
+struct QuadDouble
+{
+  QuadDouble(double value = 0) : x{value, 0, 0, 0}
+  {
+  }
+
+  explicit QuadDouble(const BigFixed& value);
+
+  QuadDouble operator+(const QuadDouble& other) const;
+
+  QuadDouble operator-() const
+  {
+    QuadDouble negated;
+    for (int i = 0; i < 4; i++)
+      negated.x[i] = -x[i];
+    return negated;
+  }
+
+  QuadDouble operator-(const QuadDouble& other) const
+  {
+    return *this + -other;
+  }
+
+  QuadDouble operator*(const QuadDouble& other) const;
+
+  double x[4]; // largest first, each one below the rounding of the last
+};
+
+// the value of any of the number types, rounded
+inline double toDouble(double value)
+{
+  return value;
+}
+
+inline double toDouble(const DoubleDouble& value)
+{
+  return value.hi + value.lo;
+}
+
+inline double toDouble(const QuadDouble& value)
+{
+  return value.x[0] + value.x[1];
+}
+
+inline double toDouble(const BigFixed& value)
+{
+  return value.toDouble();
+}
+
+// the number types from cheapest to most precise
+enum class NumberType
+{
+  Double,
+  DoubleDouble,
+  QuadDouble,
+  BigFixed
+};
+
+// the cheapest type that tells apart points resolution apart, for
+// coordinates up to about 2 and some bits to spare for rounding errors
+// that build up over the iterations
+NumberType getNumberType(double resolution);
+
+const char* getNumberTypeName(NumberType type);
+} // namespace automata
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef UTILS_PROCESS_MEMORY
+#define UTILS_PROCESS_MEMORY
+
+#include <cstdint>
+
+namespace automata
+{
+// the most memory the process has had resident at once since it started, in
+// bytes. 0 where the os doesn't say
+uint64_t getPeakResidentBytes();
+} // namespace automata
+
+#endif
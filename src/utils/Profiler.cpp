@@ -0,0 +1,249 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+using automata::ProfileEvent;
+using automata::profiler::ringSize;
+
+// the fields are atomics so a reader racing the writer isn't undefined, a
+// slot overwritten mid read is dropped by the count check in read
+struct Slot
+{
+  std::atomic<const char*> name;
+  std::atomic<uint64_t> startNs;
+  std::atomic<uint64_t> endNs;
+  std::atomic<uint32_t> depth;
+};
+
+// written by one thread, read by any
+class Ring
+{
+public:
+  Ring(uint32_t thread) : m_thread(thread), m_written(0)
+  {
+  }
+
+  void push(const char* name, uint64_t startNs, uint64_t endNs, uint32_t depth)
+  {
+    uint64_t index = m_written.load(std::memory_order_relaxed);
+    Slot& slot = m_slots[index % ringSize];
+    // a reader that sees any of the stores below sees m_written at index
+    // after its acquire fence, and drops the slot as lapped. Without it the
+    // stores could show before the last push's count on weakly ordered cpus
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.endNs.store(endNs, std::memory_order_relaxed);
+    slot.depth.store(depth, std::memory_order_relaxed);
+    m_written.store(index + 1, std::memory_order_release);
+  }
+
+  void read(std::vector<ProfileEvent>& out) const
+  {
+    uint64_t end = m_written.load(std::memory_order_acquire);
+    uint64_t begin = end > ringSize ? end - ringSize : 0;
+    size_t first = out.size();
+    for (uint64_t i = begin; i < end; i++)
+    {
+      const Slot& slot = m_slots[i % ringSize];
+      out.push_back(ProfileEvent{slot.name.load(std::memory_order_relaxed),
+                                 slot.startNs.load(std::memory_order_relaxed),
+                                 slot.endNs.load(std::memory_order_relaxed),
+                                 slot.depth.load(std::memory_order_relaxed),
+                                 m_thread});
+    }
+    // the writer may have lapped the oldest slots while they were read, or be
+    // part way through the next one
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t written = m_written.load(std::memory_order_relaxed);
+    if (written >= begin + ringSize)
+    {
+      uint64_t lapped = std::min(end, written - ringSize + 1) - begin;
+      out.erase(out.begin() + first, out.begin() + first + lapped);
+    }
+  }
+
+  uint32_t getThread() const
+  {
+    return m_thread;
+  }
+
+  std::string name; // guarded by the registry mutex
+
+private:
+  uint32_t m_thread;
+  std::atomic<uint64_t> m_written;
+  Slot m_slots[ringSize];
+};
+
+// the rings of every thread that has opened a zone. They outlive their
+// threads, so the last zones of a finished thread still show
+struct Registry
+{
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Ring>> rings;
+  std::atomic<bool> enabled{true};
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+};
+
+Registry& getRegistry()
+{
+  static Registry registry;
+  return registry;
+}
+
+// made the first time the thread opens a zone
+Ring& getThreadRing()
+{
+  thread_local Ring* ring = nullptr;
+  if (!ring)
+  {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.rings.emplace_back(new Ring(registry.rings.size()));
+    ring = registry.rings.back().get();
+  }
+  return *ring;
+}
+
+thread_local uint32_t openZones = 0;
+
+void writeJsonString(std::FILE* out, const char* text)
+{
+  std::fputc('"', out);
+  for (const char* c = text; *c; c++)
+  {
+    if (*c == '"' || *c == '\\')
+      std::fputc('\\', out);
+    if ((unsigned char)*c >= 0x20)
+      std::fputc(*c, out);
+  }
+  std::fputc('"', out);
+}
+} // namespace
+
+namespace automata
+{
+ProfileZone::ProfileZone(const char* name)
+  : m_name(name), m_start(0), m_active(profiler::isEnabled())
+{
+  if (!m_active)
+    return;
+  openZones++;
+  m_start = profiler::getTimeNs();
+}
+
+ProfileZone::~ProfileZone()
+{
+  if (!m_active)
+    return;
+  uint64_t end = profiler::getTimeNs();
+  openZones--;
+  getThreadRing().push(m_name, m_start, end, openZones);
+}
+
+namespace profiler
+{
+void setEnabled(bool enabled)
+{
+  getRegistry().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool isEnabled()
+{
+  return getRegistry().enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t getTimeNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now() - getRegistry().start)
+    .count();
+}
+
+void setThreadName(const std::string& name)
+{
+  Ring& ring = getThreadRing();
+  std::lock_guard<std::mutex> lock(getRegistry().mutex);
+  ring.name = name;
+}
+
+std::vector<ProfileEvent> collectEvents()
+{
+  Registry& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::vector<ProfileEvent> events;
+  for (const auto& ring : registry.rings)
+    ring->read(events);
+  return events;
+}
+
+std::vector<ZoneSummary> summarizeZones(const std::vector<ProfileEvent>& events)
+{
+  // names are compared as strings, the same literal can have two addresses
+  std::map<std::string, std::pair<const char*, std::vector<double>>> zones;
+  for (const ProfileEvent& event : events)
+  {
+    auto& zone = zones[event.name];
+    zone.first = event.name;
+    zone.second.push_back((event.endNs - event.startNs) / 1e6);
+  }
+  std::vector<ZoneSummary> summaries;
+  for (auto& zone : zones)
+    summaries.push_back(ZoneSummary{zone.second.first,
+                                    zone.second.second.size(),
+                                    summarize(std::move(zone.second.second))});
+  return summaries;
+}
+
+bool writeChromeTrace(const std::string& path)
+{
+  std::vector<ProfileEvent> events = collectEvents();
+  std::FILE* out = std::fopen(path.c_str(), "w");
+  if (!out)
+    return false;
+  std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool first = true;
+  {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& ring : registry.rings)
+    {
+      if (ring->name.empty())
+        continue;
+      std::fprintf(out,
+                   "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                   "\"tid\":%u,\"args\":{\"name\":",
+                   first ? "" : ",\n", ring->getThread());
+      writeJsonString(out, ring->name.c_str());
+      std::fprintf(out, "}}");
+      first = false;
+    }
+  }
+  // complete events, timestamps in microseconds
+  for (const ProfileEvent& event : events)
+  {
+    std::fprintf(out, "%s{\"name\":", first ? "" : ",\n");
+    writeJsonString(out, event.name);
+    std::fprintf(out,
+                 ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+                 "\"dur\":%.3f}",
+                 event.thread, event.startNs / 1e3,
+                 (event.endNs - event.startNs) / 1e3);
+    first = false;
+  }
+  std::fprintf(out, "\n]}\n");
+  return std::fclose(out) == 0;
+}
+} // namespace profiler
+} // namespace automata
@@ -0,0 +1,78 @@
+#ifndef UTILS_PROFILER
+#define UTILS_PROFILER
+
+#include "Statistics.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace automata
+{
+// one timed zone as it ended, in nanoseconds since the profiler started
+struct ProfileEvent
+{
+  const char* name;
+  uint64_t startNs;
+  uint64_t endNs;
+  uint32_t depth; // of zones open around it on its thread
+  uint32_t thread; // in the order threads first opened a zone
+};
+
+// how long a zone took over the events still held, in milliseconds
+struct ZoneSummary
+{
+  const char* name;
+  uint64_t count;
+  Summary ms;
+};
+
+// times its own lifetime on the calling thread. name has to outlive the
+// profiler, a string literal like "Conways::step". Does nothing while the
+// profiler is disabled
+class ProfileZone
+{
+public:
+  explicit ProfileZone(const char* name);
+
+  ~ProfileZone();
+
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+  const char* m_name;
+  uint64_t m_start;
+  bool m_active;
+};
+
+// every thread writes its zones into a ring of its own without locking, and
+// the last ringSize of them can be read back from any thread
+namespace profiler
+{
+const uint32_t ringSize = 1 << 13;
+
+void setEnabled(bool enabled);
+
+bool isEnabled();
+
+// since the profiler started
+uint64_t getTimeNs();
+
+// shown in place of the thread number in traces
+void setThreadName(const std::string& name);
+
+// the events of every thread, each thread's in the order they ended
+std::vector<ProfileEvent> collectEvents();
+
+// by name, sorted by name
+std::vector<ZoneSummary>
+summarizeZones(const std::vector<ProfileEvent>& events);
+
+// every event held in the chrome trace event format, for chrome://tracing
+// or perfetto. Returns false if the file can't be written
+bool writeChromeTrace(const std::string& path);
+} // namespace profiler
+} // namespace automata
+
+#endif
@@ -0,0 +1,193 @@
+#include "ProfilerOverlay.hpp"
+#include "Profiler.hpp"
+
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+using automata::ProfileEvent;
+
+const uint32_t maxFrames = 120;
+const char* const tracePath = "automata_trace.json";
+
+// the time each zone spent outside the zones it opened, in milliseconds
+struct FrameTimes
+{
+  double totalMs;
+  std::map<std::string, double> selfMs;
+};
+
+// the frames the thread that times "Frame" finished, oldest first
+std::vector<FrameTimes> getFrames(const std::vector<ProfileEvent>& events)
+{
+  auto frame = std::find_if(events.begin(), events.end(),
+                            [](const ProfileEvent& event) {
+                              return event.depth == 0 &&
+                                     !std::strcmp(event.name, "Frame");
+                            });
+  if (frame == events.end())
+    return {};
+  uint32_t thread = frame->thread;
+
+  // a thread's zones end before the zone around them, so the time of each
+  // depth's children is known when its own zone ends
+  std::vector<FrameTimes> frames;
+  std::vector<double> childMs;
+  FrameTimes current{0, {}};
+  // the ring may have lost the start of the first frame
+  bool started = false;
+  for (const ProfileEvent& event : events)
+  {
+    if (event.thread != thread)
+      continue;
+    if (childMs.size() < event.depth + 2)
+      childMs.resize(event.depth + 2, 0);
+    double ms = (event.endNs - event.startNs) / 1e6;
+    current.selfMs[event.name] += ms - childMs[event.depth + 1];
+    childMs[event.depth + 1] = 0;
+    childMs[event.depth] += ms;
+    if (event.depth == 0)
+    {
+      if (started && !std::strcmp(event.name, "Frame"))
+      {
+        current.totalMs = ms;
+        frames.push_back(std::move(current));
+      }
+      started = true;
+      current = FrameTimes{0, {}};
+      childMs.assign(childMs.size(), 0);
+    }
+  }
+  if (frames.size() > maxFrames)
+    frames.erase(frames.begin(), frames.end() - maxFrames);
+  return frames;
+}
+
+ImU32 getZoneColor(const std::string& name)
+{
+  float hue = (std::hash<std::string>{}(name) % 360) / 360.0f;
+  return ImColor::HSV(hue, 0.6f, 0.9f);
+}
+
+void showFrameGraph(const std::vector<FrameTimes>& frames)
+{
+  double maxMs = 1000.0 / 60;
+  for (const FrameTimes& frame : frames)
+    maxMs = std::max(maxMs, frame.totalMs);
+
+  ImVec2 size(ImGui::GetContentRegionAvail().x, 120);
+  ImVec2 origin = ImGui::GetCursorScreenPos();
+  ImDrawList* drawList = ImGui::GetWindowDrawList();
+  drawList->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y),
+                          IM_COL32(30, 30, 30, 255));
+  ImGui::InvisibleButton("frames", size);
+  bool hovered = ImGui::IsItemHovered();
+
+  float barWidth = size.x / maxFrames;
+  float scale = size.y / maxMs;
+  float bottom = origin.y + size.y;
+  for (uint32_t i = 0; i < frames.size(); i++)
+  {
+    // the newest frame on the right
+    float left = origin.x + (maxFrames - frames.size() + i) * barWidth;
+    float right = left + std::max(barWidth - 1, 1.0f);
+    float top = bottom;
+    for (const auto& zone : frames[i].selfMs)
+    {
+      float height = zone.second * scale;
+      drawList->AddRectFilled(ImVec2(left, top - height), ImVec2(right, top),
+                              getZoneColor(zone.first));
+      top -= height;
+    }
+
+    float mouseX = ImGui::GetIO().MousePos.x;
+    if (hovered && mouseX >= left && mouseX < left + barWidth)
+    {
+      ImGui::BeginTooltip();
+      ImGui::Text("Frame %.3f ms", frames[i].totalMs);
+      for (const auto& zone : frames[i].selfMs)
+        ImGui::Text("%s %.3f ms", zone.first.c_str(), zone.second);
+      ImGui::EndTooltip();
+    }
+  }
+  // the 60 FPS budget
+  float budget = bottom - (1000.0f / 60) * scale;
+  drawList->AddLine(ImVec2(origin.x, budget), ImVec2(origin.x + size.x, budget),
+                    IM_COL32(255, 255, 255, 96));
+  ImGui::Text("%.1f ms at the top", maxMs);
+}
+
+void showZoneTable(const std::vector<ProfileEvent>& events)
+{
+  ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+  if (!ImGui::BeginTable("zones", 5, flags))
+    return;
+  ImGui::TableSetupColumn("Zone");
+  ImGui::TableSetupColumn("Count");
+  ImGui::TableSetupColumn("p50 ms");
+  ImGui::TableSetupColumn("p99 ms");
+  ImGui::TableSetupColumn("Max ms");
+  ImGui::TableHeadersRow();
+  for (const auto& zone : automata::profiler::summarizeZones(events))
+  {
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::ColorButton(zone.name, ImColor(getZoneColor(zone.name)),
+                       ImGuiColorEditFlags_NoTooltip, ImVec2(10, 10));
+    ImGui::SameLine();
+    ImGui::TextUnformatted(zone.name);
+    ImGui::TableNextColumn();
+    ImGui::Text("%llu", (unsigned long long)zone.count);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", zone.ms.median);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", zone.ms.p99);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", zone.ms.max);
+  }
+  ImGui::EndTable();
+}
+} // namespace
+
+namespace automata
+{
+void showProfilerOverlay(bool* open)
+{
+  static std::string exportResult;
+
+  ImGui::SetNextWindowSize(ImVec2(520, 480), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Profiler", open))
+  {
+    ImGui::End();
+    return;
+  }
+
+  bool enabled = profiler::isEnabled();
+  if (ImGui::Checkbox("Record zones", &enabled))
+    profiler::setEnabled(enabled);
+  ImGui::SameLine();
+  if (ImGui::Button("Export Chrome trace"))
+  {
+    exportResult = profiler::writeChromeTrace(tracePath)
+                     ? std::string("Saved ") + tracePath
+                     : std::string("Couldn't write ") + tracePath;
+  }
+  if (!exportResult.empty())
+  {
+    ImGui::SameLine();
+    ImGui::TextUnformatted(exportResult.c_str());
+  }
+
+  std::vector<ProfileEvent> events = profiler::collectEvents();
+  showFrameGraph(getFrames(events));
+  showZoneTable(events);
+  ImGui::End();
+}
+} // namespace automata
@@ -0,0 +1,12 @@
+#ifndef UTILS_PROFILER_OVERLAY
+#define UTILS_PROFILER_OVERLAY
+
+namespace automata
+{
+// a window with the time of the last frames stacked by zone, a table of
+// every zone's p50 and p99 and a button to save a chrome trace. Frames are
+// the zones named "Frame"
+void showProfilerOverlay(bool* open);
+} // namespace automata
+
+#endif
@@ -0,0 +1,38 @@
+#include "Statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace automata
+{
+double getPercentile(const std::vector<double>& sorted, double percent)
+{
+  if (sorted.empty())
+    return 0;
+  // nearest rank, so every percentile is one of the samples
+  size_t rank = (size_t)std::ceil(percent / 100 * sorted.size());
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+Summary summarize(std::vector<double> samples)
+{
+  Summary summary{};
+  if (samples.empty())
+    return summary;
+  std::sort(samples.begin(), samples.end());
+  summary.min = samples.front();
+  summary.median = getPercentile(samples, 50);
+  summary.p99 = getPercentile(samples, 99);
+  summary.max = samples.back();
+  for (double sample : samples)
+    summary.mean += sample;
+  summary.mean /= samples.size();
+  if (samples.size() > 1)
+  {
+    for (double sample : samples)
+      summary.variance += (sample - summary.mean) * (sample - summary.mean);
+    summary.variance /= samples.size() - 1;
+  }
+  return summary;
+}
+} // namespace automata
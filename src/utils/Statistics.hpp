@@ -0,0 +1,27 @@
+#ifndef UTILS_STATISTICS
+#define UTILS_STATISTICS
+
+#include <vector>
+
+namespace automata
+{
+// of timings, which are skewed towards the slow side, so the median is the
+// number to compare and the rest say how far to trust it
+struct Summary
+{
+  double min;
+  double median;
+  double p99;
+  double max;
+  double mean;
+  double variance; // of the samples, not of the mean
+};
+
+// the value percent of the way through sorted, 0 if it is empty
+double getPercentile(const std::vector<double>& sorted, double percent);
+
+// samples in any order, all zeros if there are none
+Summary summarize(std::vector<double> samples);
+} // namespace automata
+
+#endif
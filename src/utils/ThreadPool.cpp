@@ -0,0 +1,155 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace automata
+{
+ThreadPool::ThreadPool(uint32_t numThreads)
+  : m_task(nullptr),
+    m_pending(0),
+    m_stolen(0),
+    m_generation(0),
+    m_error(nullptr),
+    m_stop(false)
+{
+  for (uint32_t i = 0; i <= numThreads; i++)
+    m_queues.emplace_back(new TaskQueue());
+  for (uint32_t i = 0; i < numThreads; i++)
+    m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (auto& worker : m_workers)
+    worker.join();
+}
+
+ThreadPool& ThreadPool::getShared()
+{
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+
+bool ThreadPool::takeTask(uint32_t queue, uint32_t& index)
+{
+  {
+    TaskQueue& own = *m_queues[queue];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty())
+    {
+      index = own.tasks.front();
+      own.tasks.pop_front();
+      return true;
+    }
+  }
+  // steal from the far end, away from where the owner is working
+  for (uint32_t i = 1; i < m_queues.size(); i++)
+  {
+    TaskQueue& victim = *m_queues[(queue + i) % m_queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty())
+    {
+      index = victim.tasks.back();
+      victim.tasks.pop_back();
+      m_stolen++;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::runTasks(uint32_t queue)
+{
+  uint32_t index;
+  while (takeTask(queue, index))
+  {
+    // set before the deques were filled, so it belongs to this index
+    const std::function<void(uint32_t)>* task = m_task;
+    try
+    {
+      (*task)(index);
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!m_error)
+        m_error = std::current_exception();
+    }
+    if (--m_pending == 0)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_finished.notify_all();
+    }
+  }
+}
+
+void ThreadPool::workerLoop(uint32_t queue)
+{
+  uint64_t seen = 0;
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+      if (m_stop)
+        return;
+      seen = m_generation;
+    }
+    runTasks(queue);
+  }
+}
+
+void ThreadPool::parallelFor(uint32_t count,
+                             const std::function<void(uint32_t)>& task)
+{
+  if (count == 0)
+    return;
+  if (count == 1 || m_workers.empty())
+  {
+    for (uint32_t i = 0; i < count; i++)
+      task(i);
+    return;
+  }
+
+  std::lock_guard<std::mutex> submit(m_submitMutex);
+  m_task = &task;
+  m_pending = count;
+  m_error = nullptr;
+  uint32_t numQueues = m_queues.size();
+  for (uint32_t q = 0; q < numQueues; q++)
+  {
+    TaskQueue& queue = *m_queues[q];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    for (uint32_t i = (uint64_t)count * q / numQueues;
+         i < (uint64_t)count * (q + 1) / numQueues; i++)
+      queue.tasks.push_back(i);
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_generation++;
+  }
+  m_wake.notify_all();
+
+  runTasks(numQueues - 1);
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_finished.wait(lock, [this] { return m_pending == 0; });
+  m_task = nullptr;
+  if (m_error)
+    std::rethrow_exception(m_error);
+}
+
+void ThreadPool::forEachBand(
+  uint64_t count, uint32_t numBands,
+  const std::function<void(uint64_t, uint64_t)>& task)
+{
+  numBands = std::max<uint64_t>(1, std::min<uint64_t>(numBands, count));
+  parallelFor(numBands, [&](uint32_t band) {
+    task(count * band / numBands, count * (band + 1) / numBands);
+  });
+}
+} // namespace automata
@@ -0,0 +1,84 @@
+#ifndef UTILS_THREAD_POOL
+#define UTILS_THREAD_POOL
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace automata
+{
+// worker threads that live as long as the pool, so stepping a simulation
+// does not pay for starting threads every generation. Each thread has its
+// own deque of tasks and steals from the others once it runs dry, so uneven
+// tasks don't leave threads idle
+class ThreadPool
+{
+public:
+  ThreadPool(uint32_t numThreads);
+
+  ~ThreadPool();
+
+  // one worker per hardware thread, shared by every automaton
+  static ThreadPool& getShared();
+
+  uint32_t getNumThreads()
+  {
+    return m_workers.size();
+  }
+
+  // tasks a thread took from another thread's deque, since the pool started
+  uint64_t getStolenCount()
+  {
+    return m_stolen;
+  }
+
+  // runs task(i) for every i in [0, count) and waits for all of them. The
+  // calling thread helps out. Tasks must not call back into the same pool.
+  // Every thread starts on a contiguous run of indices, so neighboring
+  // tasks tend to run on the same thread
+  void parallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+
+  // splits [0, count) into numBands contiguous ranges of nearly equal size
+  // and runs task(begin, end) for each of them in parallel
+  void forEachBand(uint64_t count, uint32_t numBands,
+                   const std::function<void(uint64_t, uint64_t)>& task);
+
+private:
+  struct TaskQueue
+  {
+    std::mutex mutex;
+    std::deque<uint32_t> tasks;
+  };
+
+  void workerLoop(uint32_t queue);
+
+  // the front of our own deque, else the back of someone else's
+  bool takeTask(uint32_t queue, uint32_t& index);
+
+  // runs tasks until every deque is empty
+  void runTasks(uint32_t queue);
+
+  std::vector<std::thread> m_workers;
+  // one per worker, the last one belongs to the thread calling parallelFor
+  std::vector<std::unique_ptr<TaskQueue>> m_queues;
+  std::mutex m_submitMutex; // one parallelFor at a time
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_finished;
+  std::atomic<const std::function<void(uint32_t)>*> m_task;
+  std::atomic<uint32_t> m_pending;
+  std::atomic<uint64_t> m_stolen;
+  uint64_t m_generation; // bumped for every parallelFor, wakes the workers
+  std::exception_ptr m_error;
+  bool m_stop;
+};
+} // namespace automata
+
+#endif